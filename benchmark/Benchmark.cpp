@@ -0,0 +1,393 @@
+// Benchmark of the packing engines over generated catalogs.
+// the engines come from the packing library and the catalogs from the generator, not from the program
+#include "../folderfillingtest/SoundPacking.h"
+#include "CatalogGenerator.h"
+#include "../folderfillingtest/AllocationCounter.h"  // threadAllocations, measure counts the difference over the runs of an engine
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <memory_resource>
+#include <cmath>
+#ifdef __unix__
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+
+//########################### ENGINES ###################################
+
+// the folder tables of the engine being measured, measure releases it after every run
+// like the program does after every algorithm
+thread_local pmr::monotonic_buffer_resource resultArena;
+using FolderTable = soundpacking::FolderTable<int, pmr::polymorphic_allocator<int>>;
+
+// one packing engine as the benchmark sees it
+struct BenchmarkEngine {
+    string name;
+    bool decreasing;        // gets the files sorted by decreasing duration, sorting is not timed
+    // rough number of operations for n files, f folders (the lower bound) and capacity C,
+    // engines above --max-work are skipped instead of running for hours
+    function<double(double n, double f, double C)> work;
+    // packs the durations, returns the folder count
+    function<int(int capacity, const vector<int>& durations)> pack;
+};
+
+// folder count of a placement policy of the library, the file index is the key
+template <class Policy>
+int countFolders(int capacity, const vector<int>& durations)
+{
+    vector<soundpacking::Item<int, int>> items(durations.size());
+    for (size_t i = 0; i < durations.size(); i++)
+    {
+        items[i] = { (int)i, durations[i] };
+    }
+    auto packing = soundpacking::pack<Policy>(items, capacity, pmr::polymorphic_allocator<int>(&resultArena));
+    return (int)packing.folders.size();
+}
+
+// folder count of a subset-sum engine of the library filling one folder after the other
+template <class Engine>
+int countFilledFolders(Engine engine, const vector<int>& durations)
+{
+    FolderTable folders(&resultArena);
+    soundpacking::fillFolders(engine, durations, folders);
+    return (int)folders.size();
+}
+
+// the DP engines keep one (n+1)x(C+1) int table, larger ones are skipped
+const double maxDPTableBytes = 2e9;
+
+vector<BenchmarkEngine> benchmarkEngines()
+{
+    // the decreasing engines get the durations already sorted, they run the plain policies
+    auto worstFitPQEngine = countFolders<soundpacking::WorstFitHeap>;
+    auto worstFitLinearEngine = countFolders<soundpacking::WorstFitLinear>;
+    auto worstFitBucketsEngine = countFolders<soundpacking::WorstFitBuckets>;
+
+    auto heapWork = [](double n, double f, double) { return n * log2(f + 1); };
+    auto scanWork = [](double n, double f, double) { return n * f; };
+    auto logWork = [](double n, double f, double C) { return n * (log2(f + 1) + log2(C + 1)); };
+    auto tableWork = [](double n, double f, double C) {
+        return (n + 1) * (C + 1) * sizeof(int) > maxDPTableBytes ? INFINITY : n * f * C / 2;
+    };
+    auto bitsetWork = [](double n, double f, double C) { return n * f * C / 64; };
+    // at most min(C, states) sums per file, most folders stop early on a full one
+    auto sparseWork = [](double n, double f, double C) { return n * f * min(C, (double)soundpacking::SparseSubsetSum<>::defaultMaxStates) / 8; };
+    auto classesWork = [](double n, double f, double C) { return n * log2(n + 1) + f * min(n, C) * C; };
+
+    return {
+        { "worstFitPQ", false, heapWork, worstFitPQEngine },
+        { "worstFitLinear", false, scanWork, worstFitLinearEngine },
+        { "worstFitBuckets", false, logWork, worstFitBucketsEngine },
+        { "worstFitDecreasingPQ", true, heapWork, worstFitPQEngine },
+        { "worstFitDecreasingLinear", true, scanWork, worstFitLinearEngine },
+        { "worstFitDecreasingBuckets", true, logWork, worstFitBucketsEngine },
+        { "firstFitDecreasing", true, scanWork, countFolders<soundpacking::FirstFitLinear> },
+        { "firstFitDecreasingTree", true, logWork, countFolders<soundpacking::FirstFit> },
+        { "bestFit", false, logWork, countFolders<soundpacking::BestFitBuckets> },
+        { "bestFitDecreasing", true, logWork, countFolders<soundpacking::BestFitBuckets> },
+        { "folderFillingTable", false, tableWork, [](int capacity, const vector<int>& durations) {
+            return countFilledFolders(soundpacking::TableSubsetSum<>(capacity, durations.size()), durations); } },
+        { "folderFillingBitset", false, bitsetWork, [](int capacity, const vector<int>& durations) {
+            return countFilledFolders(soundpacking::BitsetSubsetSum<>(capacity), durations); } },
+        { "folderFillingSparse", false, sparseWork, [](int capacity, const vector<int>& durations) {
+            return countFilledFolders(soundpacking::SparseSubsetSum<>(capacity), durations); } },
+        { "folderFillingClasses", false, classesWork, [](int capacity, const vector<int>& durations) {
+            FolderTable folders(&resultArena);
+            soundpacking::fillFoldersByDuration(capacity, durations, folders);
+            return (int)folders.size(); } },
+        //new engines should be added here
+    };
+}
+
+
+
+//########################### MEASUREMENTS ###################################
+
+// milliseconds elapsed since start
+double millisecondsSince(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
+
+// on Linux the peak resident memory is reset before every engine (clear_refs 5),
+// so the reported peak is the one reached while that engine ran.
+// elsewhere it is the peak of the whole benchmark so far
+void resetPeakRss()
+{
+#ifdef __linux__
+    ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+#endif
+}
+
+// peak resident memory in KB, -1 where it is not available
+long long peakRssKB()
+{
+#ifdef __linux__
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line))
+    {
+        if (line.rfind("VmHWM:", 0) == 0) return stoll(line.substr(6));
+    }
+#endif
+#ifdef __unix__
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+    return -1;
+}
+
+// nearest rank percentile of sorted values
+double percentile(const vector<double>& sorted, double p)
+{
+    size_t rank = (size_t)ceil(p * sorted.size());
+    return sorted[max<size_t>(rank, 1) - 1];
+}
+
+// one line of the report
+struct BenchmarkResult {
+    string distribution;
+    int files;
+    int capacity;
+    string engine;
+    bool skipped = false;
+    int repeats = 0;
+    double medianMilliseconds = 0, p95Milliseconds = 0;
+    long long peakRssKB = -1;
+    long long allocations = 0;  // heap allocations of one run
+    int folders = 0;
+    long long lowerBound = 0;   // best of ceil(total duration / capacity) and the Martello-Toth L2 bound
+};
+
+// runs an engine "repeats" times on the same catalog
+BenchmarkResult measure(const BenchmarkEngine& engine, int capacity, const vector<int>& durations, int repeats)
+{
+    BenchmarkResult result;
+    vector<double> milliseconds;
+    resetPeakRss();
+    long long allocationsBefore = threadAllocations;
+    for (int run = 0; run < repeats; run++)
+    {
+        auto start = chrono::high_resolution_clock::now();
+        result.folders = engine.pack(capacity, durations);
+        milliseconds.push_back(millisecondsSince(start));
+        resultArena.release(); // every run starts from an empty arena, like every algorithm of the program
+    }
+    result.allocations = (threadAllocations - allocationsBefore) / max(1, repeats);
+    result.peakRssKB = peakRssKB();
+    sort(milliseconds.begin(), milliseconds.end());
+    result.repeats = repeats;
+    result.medianMilliseconds = percentile(milliseconds, 0.5);
+    result.p95Milliseconds = percentile(milliseconds, 0.95);
+    return result;
+}
+
+void writeCsv(ostream& out, const vector<BenchmarkResult>& results)
+{
+    out << "distribution,files,capacity,engine,status,repeats,median_ms,p95_ms,peak_rss_kb,allocations,folders,lower_bound,folders_over_bound\n";
+    for (const BenchmarkResult& r : results)
+    {
+        out << r.distribution << "," << r.files << "," << r.capacity << "," << r.engine << ","
+            << (r.skipped ? "skipped" : "ok") << "," << r.repeats << ",";
+        if (r.skipped)
+            out << ",,,,,";
+        else
+            out << r.medianMilliseconds << "," << r.p95Milliseconds << "," << r.peakRssKB << "," << r.allocations << "," << r.folders << ",";
+        out << r.lowerBound << ",";
+        if (!r.skipped) out << (double)r.folders / max(1LL, r.lowerBound);
+        out << "\n";
+    }
+}
+
+void writeJson(ostream& out, const vector<BenchmarkResult>& results)
+{
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const BenchmarkResult& r = results[i];
+        out << "  {\"distribution\": \"" << r.distribution << "\", \"files\": " << r.files
+            << ", \"capacity\": " << r.capacity << ", \"engine\": \"" << r.engine
+            << "\", \"status\": \"" << (r.skipped ? "skipped" : "ok") << "\", \"repeats\": " << r.repeats;
+        if (!r.skipped)
+        {
+            out << ", \"median_ms\": " << r.medianMilliseconds << ", \"p95_ms\": " << r.p95Milliseconds
+                << ", \"peak_rss_kb\": " << r.peakRssKB << ", \"allocations\": " << r.allocations << ", \"folders\": " << r.folders
+                << ", \"folders_over_bound\": " << (double)r.folders / max(1LL, r.lowerBound);
+        }
+        out << ", \"lower_bound\": " << r.lowerBound << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+
+
+//########################### MAIN ###################################
+
+// splits "a,b,c"
+vector<string> splitList(const string& value)
+{
+    vector<string> items;
+    stringstream list(value);
+    string item;
+    while (getline(list, item, ','))
+    {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+int main(int argc, char* argv[])
+{
+    vector<int> fileCounts = { 1000, 10000, 100000 };
+    vector<int> capacities = { 1200 };
+    vector<DurationDistribution> distributions = { DurationDistribution::Uniform, DurationDistribution::HeavyTailed,
+        DurationDistribution::Duplicates, DurationDistribution::NearCapacity };
+    vector<string> engineNames;     // empty runs every engine
+    int repeats = 5;
+    uint64_t seed = 1;
+    double maxWork = 2e9;
+    string format = "csv", output;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string argument = argv[i];
+        size_t equals = argument.find('=');
+        string name = argument.substr(0, equals);
+        string value = equals == string::npos ? "" : argument.substr(equals + 1);
+        bool valid = !value.empty();
+
+        try
+        {
+            if (name == "--files" || name == "--capacities")
+            {
+                vector<int>& list = (name == "--files" ? fileCounts : capacities);
+                list.clear();
+                for (const string& item : splitList(value))
+                {
+                    list.push_back(stoi(item));
+                    valid = valid && list.back() > 0;
+                }
+            }
+            else if (name == "--distributions")
+            {
+                distributions.clear();
+                for (const string& item : splitList(value))
+                {
+                    distributions.emplace_back();
+                    valid = valid && parseDistribution(item, distributions.back());
+                }
+            }
+            else if (name == "--engines")
+                engineNames = splitList(value);
+            else if (name == "--repeat")
+                valid = valid && (repeats = stoi(value)) > 0;
+            else if (name == "--seed")
+                seed = stoull(value);
+            else if (name == "--max-work")
+                maxWork = stod(value);
+            else if (name == "--format")
+                valid = ((format = value) == "csv" || format == "json");
+            else if (name == "--output")
+                output = value;
+            else
+                valid = false;
+        }
+        catch (const exception&)
+        {
+            valid = false;
+        }
+
+        if (!valid)
+        {
+            cerr << "Unknown option: " << argument << endl;
+            cerr << "Options: --files=N,N,... --capacities=C,C,... --distributions=uniform,heavy-tailed,duplicates,near-capacity" << endl;
+            cerr << "         --engines=name,... --repeat=N --seed=N --max-work=OPERATIONS (skip engines estimated above it)" << endl;
+            cerr << "         --format=csv|json --output=<file> (default standard output)" << endl;
+            return 1;
+        }
+    }
+
+    vector<BenchmarkEngine> engines = benchmarkEngines();
+    if (!engineNames.empty())
+    {
+        vector<BenchmarkEngine> selected;
+        for (const string& engineName : engineNames)
+        {
+            auto engine = find_if(engines.begin(), engines.end(), [&](const BenchmarkEngine& e) { return e.name == engineName; });
+            if (engine == engines.end())
+            {
+                cerr << "Unknown engine: " << engineName << endl;
+                return 1;
+            }
+            selected.push_back(*engine);
+        }
+        engines = selected;
+    }
+
+    vector<BenchmarkResult> results;
+    for (DurationDistribution distribution : distributions)
+    {
+        for (int fileCount : fileCounts)
+        {
+            for (int capacity : capacities)
+            {
+                CatalogSpec spec{ fileCount, capacity, distribution, seed };
+                vector<int> durations = generateDurations(spec);
+
+                vector<int> sortedDurations = durations;
+                sort(sortedDurations.begin(), sortedDurations.end(), greater<int>());
+                long long lowerBound = soundpacking::lowerBounds(sortedDurations, capacity).best();
+
+                for (const BenchmarkEngine& engine : engines)
+                {
+                    BenchmarkResult result;
+                    if (engine.work(fileCount, lowerBound, capacity) > maxWork)
+                    {
+                        result.skipped = true;
+                    }
+                    else
+                    {
+                        result = measure(engine, capacity, engine.decreasing ? sortedDurations : durations, repeats);
+                    }
+                    result.distribution = distributionNames[(int)distribution];
+                    result.files = fileCount;
+                    result.capacity = capacity;
+                    result.engine = engine.name;
+                    result.lowerBound = lowerBound;
+                    results.push_back(result);
+
+                    cerr << result.distribution << " n=" << fileCount << " C=" << capacity << " " << engine.name << ": ";
+                    if (result.skipped)
+                        cerr << "skipped (over --max-work)" << endl;
+                    else
+                        cerr << result.medianMilliseconds << " ms median, " << result.folders << " folders" << endl;
+                }
+            }
+        }
+    }
+
+    ofstream outputFile;
+    if (!output.empty())
+    {
+        outputFile.open(output);
+        if (!outputFile.is_open())
+        {
+            cerr << "Error: Could not write " << output << endl;
+            return 1;
+        }
+    }
+    ostream& out = output.empty() ? cout : outputFile;
+    if (format == "json")
+        writeJson(out, results);
+    else
+        writeCsv(out, results);
+    return 0;
+}
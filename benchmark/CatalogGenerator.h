@@ -0,0 +1,94 @@
+#pragma once
+// Seeded generator of AudiosInfo.txt durations for the large tests (4, 5, 6) the repo does not ship,
+// shared by generate-catalog and the benchmarks.
+// the same seed and parameters give the same catalog on every platform: only mt19937_64 is used
+// (the <random> distributions are implementation defined) and mapped to durations by hand.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+enum class DurationDistribution { Uniform, HeavyTailed, Duplicates, NearCapacity };
+inline const char* distributionNames[] = { "uniform", "heavy-tailed", "duplicates", "near-capacity" };
+
+inline bool parseDistribution(const std::string& name, DurationDistribution& distribution)
+{
+    for (int i = 0; i < 4; i++)
+    {
+        if (name == distributionNames[i])
+        {
+            distribution = (DurationDistribution)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct CatalogSpec {
+    int files = 1000;
+    int capacity = 1200;        // folder capacity in seconds, no file is longer than it
+    DurationDistribution distribution = DurationDistribution::Uniform;
+    std::uint64_t seed = 1;
+    bool milliseconds = false;  // HH:MM:SS.mmm durations, generated in milliseconds
+};
+
+// uniform integer in [low, high]
+inline int uniformInt(std::mt19937_64& random, int low, int high)
+{
+    return low + (int)(random() % (std::uint64_t)(high - low + 1));
+}
+
+// uniform real in [0, 1), 53 random bits
+inline double uniformReal(std::mt19937_64& random)
+{
+    return (random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// durations in seconds (milliseconds with spec.milliseconds), all in [1, capacity]:
+// uniform        every duration equally likely
+// heavy-tailed   Pareto (alpha 1.5) from capacity/60, mostly short files and a few long ones
+// duplicates     16 distinct durations only
+// near-capacity  half the files just under the capacity (last 10%), half short (first 10%)
+//TIME COMPLEXITY: θ(n)
+inline std::vector<int> generateDurations(const CatalogSpec& spec)
+{
+    std::mt19937_64 random(spec.seed);
+    int capacity = std::max(1, spec.capacity) * (spec.milliseconds ? 1000 : 1);
+
+    std::vector<int> pool;
+    if (spec.distribution == DurationDistribution::Duplicates)
+    {
+        for (int i = 0; i < 16; i++) pool.push_back(uniformInt(random, 1, capacity));
+    }
+
+    std::vector<int> durations(spec.files);
+    for (int& duration : durations) //θ(n)
+    {
+        switch (spec.distribution)
+        {
+        case DurationDistribution::Uniform:
+            duration = uniformInt(random, 1, capacity);
+            break;
+        case DurationDistribution::HeavyTailed:
+        {
+            double scale = std::max(1.0, capacity / 60.0);
+            double pareto = scale / std::pow(1.0 - uniformReal(random), 1.0 / 1.5);
+            duration = (int)std::min<double>(capacity, pareto);
+            break;
+        }
+        case DurationDistribution::Duplicates:
+            duration = pool[random() % pool.size()];
+            break;
+        case DurationDistribution::NearCapacity:
+            if (random() & 1)
+                duration = uniformInt(random, std::max(1, capacity - capacity / 10), capacity);
+            else
+                duration = uniformInt(random, 1, std::max(1, capacity / 10));
+            break;
+        }
+    }
+    return durations;
+}
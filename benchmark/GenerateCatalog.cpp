@@ -0,0 +1,196 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "CatalogGenerator.h"
+
+using namespace std;
+namespace fs = filesystem;
+
+
+//########################### CATALOG GENERATOR ###################################
+
+// writes AudiosInfo.txt catalogs of generated durations (CatalogGenerator.h) and, optionally, audio files for them.
+
+// HH:MM:SS like the catalogs of the sample tests, HH:MM:SS.mmm for a duration in milliseconds
+string formatDuration(int duration, bool milliseconds = false)
+{
+    int totalSeconds = milliseconds ? duration / 1000 : duration;
+    char text[32];
+    snprintf(text, sizeof(text), "%02d:%02d:%02d", totalSeconds / 3600, totalSeconds / 60 % 60, totalSeconds % 60);
+    if (milliseconds) snprintf(text + strlen(text), sizeof(text) - strlen(text), ".%03d", duration % 1000);
+    return text;
+}
+
+// writes the catalog, files are named 1.mp3, 2.mp3 ... like the sample tests
+bool writeCatalog(const string& path, const vector<int>& durations, bool milliseconds = false)
+{
+    ofstream catalogFile(path);
+    if (!catalogFile.is_open())
+    {
+        cerr << "Error: Could not write " << path << endl;
+        return false;
+    }
+    catalogFile << durations.size() << "\n";
+    for (size_t i = 0; i < durations.size(); i++)
+    {
+        catalogFile << i + 1 << ".mp3 " << formatDuration(durations[i], milliseconds) << "\n";
+    }
+    return bool(catalogFile);
+}
+
+// what the audio files hold: nothing, or MPEG audio whose duration is in an Info header, a VBRI header or only in its frames
+enum class AudioContent { Empty, InfoHeader, VbriHeader, Frames };
+const char* audioContentNames[] = { "empty", "info", "vbri", "frames" };
+
+// MPEG-2 Layer III, 24000 Hz, 32 kbps, mono: 96 bytes and 24 ms per frame
+const unsigned char mp3FrameHeader[4] = { 0xFF, 0xF3, 0x44, 0xC0 };
+const int mp3FrameBytes = 96;
+const int mp3FrameMilliseconds = 24;
+
+// a silent frame, its header then zeros. "Info" or "VBRI" with the frame count when tag is given
+void writeMp3Frame(ofstream& audio, const char* tag = nullptr, uint32_t frames = 0)
+{
+    unsigned char frame[mp3FrameBytes] = {};
+    memcpy(frame, mp3FrameHeader, 4);
+    if (tag)
+    {
+        bool vbri = strcmp(tag, "VBRI") == 0;
+        int position = vbri ? 36 : 4 + 9;    // VBRI at a fixed offset, Info after the side information
+        int count = position + (vbri ? 14 : 8);
+        memcpy(frame + position, tag, 4);
+        if (!vbri) frame[position + 7] = 1; // flags: the frame count is present
+        for (int i = 0; i < 4; i++) frame[count + i] = (unsigned char)(frames >> (24 - 8 * i));
+    }
+    audio.write((const char*)frame, mp3FrameBytes);
+}
+
+// an audio file for every catalog entry, so the main program can build its folders from the catalog.
+// MPEG audio lasts the duration rounded up to a frame, it scans back to the catalog at second precision.
+// an Info or VBRI file holds its header frame and a single audio frame, a frames file all of them
+bool writeAudios(const string& directory, const vector<int>& durations, bool milliseconds = false,
+    AudioContent content = AudioContent::Empty)
+{
+    fs::create_directories(directory);
+    for (size_t i = 0; i < durations.size(); i++)
+    {
+        ofstream audio(directory + "/" + to_string(i + 1) + ".mp3", ios::binary);
+        if (!audio.is_open())
+        {
+            cerr << "Error: Could not write the audios to " << directory << endl;
+            return false;
+        }
+        long long duration = durations[i] * (milliseconds ? 1LL : 1000LL);
+        uint32_t frames = (uint32_t)((duration + mp3FrameMilliseconds - 1) / mp3FrameMilliseconds);
+        if (content == AudioContent::InfoHeader || content == AudioContent::VbriHeader)
+        {
+            writeMp3Frame(audio, content == AudioContent::InfoHeader ? "Info" : "VBRI", frames);
+            writeMp3Frame(audio);
+        }
+        else if (content == AudioContent::Frames)
+        {
+            for (uint32_t frame = 0; frame < frames; frame++) writeMp3Frame(audio);
+        }
+    }
+    return true;
+}
+
+
+
+//########################### MAIN ###################################
+
+int main(int argc, char* argv[])
+{
+    CatalogSpec spec;
+    string output, audios;
+    AudioContent content = AudioContent::Empty;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string argument = argv[i];
+        size_t equals = argument.find('=');
+        string name = argument.substr(0, equals);
+        string value = equals == string::npos ? "" : argument.substr(equals + 1);
+        bool number = !value.empty() && value.find_first_not_of("0123456789") == string::npos;
+        bool valid = false;
+
+        if (name == "--files" || name == "--capacity")
+        {
+            valid = number && stoll(value) > 0 && stoll(value) <= INT32_MAX;
+            if (valid) (name == "--files" ? spec.files : spec.capacity) = stoi(value);
+        }
+        else if (name == "--seed")
+        {
+            valid = number;
+            if (valid) spec.seed = stoull(value);
+        }
+        else if (name == "--distribution")
+        {
+            valid = parseDistribution(value, spec.distribution);
+        }
+        else if (name == "--milliseconds")
+        {
+            valid = value.empty();
+            spec.milliseconds = true;
+        }
+        else if (name == "--output" || name == "--audios")
+        {
+            valid = !value.empty();
+            (name == "--output" ? output : audios) = value;
+        }
+        else if (name == "--mp3")
+        {
+            for (int i = 1; i < 4; i++)
+            {
+                if (value == audioContentNames[i])
+                {
+                    content = (AudioContent)i;
+                    valid = true;
+                }
+            }
+        }
+
+        if (!valid)
+        {
+            cerr << "Unknown option: " << argument << endl;
+            cerr << "Options: --output=<AudiosInfo.txt> (required), --files=N, --capacity=SECONDS, --seed=N" << endl;
+            cerr << "         --distribution=uniform|heavy-tailed|duplicates|near-capacity" << endl;
+            cerr << "         --audios=<directory> (empty audio files for every entry)" << endl;
+            cerr << "           --mp3=info|vbri|frames (MPEG audio of the duration, for sound-packing --scan)" << endl;
+            cerr << "         --milliseconds (HH:MM:SS.mmm durations, capacity up to 2147483 seconds)" << endl;
+            return 1;
+        }
+    }
+    if (output.empty())
+    {
+        cerr << "Error: --output=<AudiosInfo.txt> is required" << endl;
+        return 1;
+    }
+    if (spec.milliseconds && spec.capacity > INT32_MAX / 1000)
+    {
+        cerr << "Error: --capacity is too large for --milliseconds" << endl;
+        return 1;
+    }
+
+    vector<int> durations = generateDurations(spec);
+    if (!writeCatalog(output, durations, spec.milliseconds) || (!audios.empty() && !writeAudios(audios, durations, spec.milliseconds, content)))
+    {
+        return 1;
+    }
+
+    long long totalDuration = 0;
+    for (int duration : durations) totalDuration += duration;
+    if (spec.milliseconds) totalDuration = (totalDuration + 999) / 1000;
+    cout << "Wrote " << durations.size() << " files (" << distributionNames[(int)spec.distribution]
+        << ", seed " << spec.seed << ") to " << output << endl;
+    cout << "Total duration: " << totalDuration << " seconds, at least " << (totalDuration + spec.capacity - 1) / spec.capacity
+        << " folders of " << spec.capacity << " seconds" << endl;
+    return 0;
+}
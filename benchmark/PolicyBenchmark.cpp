@@ -0,0 +1,189 @@
+// Micro-benchmark of the packing library: every placement policy instantiated for its own duration type
+// (specialized, the index inlines into the placement loop) against one generic instantiation that
+// reaches the same index through a virtual call, the policy being chosen at run time.
+// only the library and the catalog generator are used, not the program
+#include "../folderfillingtest/SoundPacking.h"
+#include "CatalogGenerator.h"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <iomanip>
+
+using namespace std;
+
+
+//########################### GENERIC INSTANTIATION ###################################
+
+// the index operations behind a virtual call, what a runtime-selected policy costs
+template <class Duration>
+struct AnyIndex {
+    virtual ~AnyIndex() = default;
+    virtual size_t take(Duration duration) = 0;
+    virtual void put(size_t folder, Duration remaining) = 0;
+    virtual long long operations() const = 0;
+};
+
+template <class Index, class Duration>
+struct AnyIndexOf : AnyIndex<Duration> {
+    Index index;
+
+    template <class Allocator>
+    AnyIndexOf(size_t items, Duration capacity, const Allocator& allocator) : index(items, capacity, allocator) {}
+
+    size_t take(Duration duration) override { return index.take(duration); }
+    void put(size_t folder, Duration remaining) override { index.put(folder, remaining); }
+    long long operations() const override { return index.operations(); }
+};
+
+const char* policyNames[] = { "FirstFit", "WorstFit", "BestFit", "WorstFitBuckets", "BestFitBuckets" };
+int runtimePolicy = 0;     // policyNames index the generic instantiation packs with
+
+// a single policy for every placement rule, its index is picked from runtimePolicy when it is built
+struct RuntimePolicy {
+    static constexpr bool decreasing = false;
+
+    template <class Duration, class Allocator>
+    struct Index {
+        unique_ptr<AnyIndex<Duration>> index;
+
+        Index(size_t items, Duration capacity, const Allocator& allocator)
+        {
+            switch (runtimePolicy)
+            {
+            case 0: index.reset(new AnyIndexOf<soundpacking::FirstFitIndex<Duration, Allocator>, Duration>(items, capacity, allocator)); break;
+            case 1: index.reset(new AnyIndexOf<soundpacking::WorstFitIndex<Duration, Allocator>, Duration>(items, capacity, allocator)); break;
+            case 2: index.reset(new AnyIndexOf<soundpacking::BestFitIndex<Duration, Allocator>, Duration>(items, capacity, allocator)); break;
+            case 3: index.reset(new AnyIndexOf<soundpacking::WorstFitBucketIndex<Duration, Allocator>, Duration>(items, capacity, allocator)); break;
+            default: index.reset(new AnyIndexOf<soundpacking::BestFitBucketIndex<Duration, Allocator>, Duration>(items, capacity, allocator)); break;
+            }
+        }
+
+        size_t take(Duration duration) { return index->take(duration); }
+        void put(size_t folder, Duration remaining) { index->put(folder, remaining); }
+        long long operations() const { return index->operations(); }
+    };
+};
+
+
+//########################### MEASUREMENTS ###################################
+
+struct PolicyResult {
+    string policy;
+    string variant;         // int32, int64 or generic
+    double medianMilliseconds = 0;
+    size_t folders = 0;
+};
+
+// median time of packing the items "repeat" times with Policy, and the folder count
+template <class Policy, class Duration>
+PolicyResult measure(const string& policy, const string& variant, const vector<soundpacking::Item<uint32_t, Duration>>& items,
+    Duration capacity, int repeat)
+{
+    PolicyResult result{ policy, variant };
+    vector<double> milliseconds;
+    for (int i = 0; i < repeat; i++)
+    {
+        auto start = chrono::steady_clock::now();
+        auto packing = soundpacking::pack<Policy>(items, capacity);
+        milliseconds.push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        result.folders = packing.folders.size();
+    }
+    sort(milliseconds.begin(), milliseconds.end());
+    result.medianMilliseconds = milliseconds[milliseconds.size() / 2];
+    return result;
+}
+
+// the specialized int32 and int64 instantiations of a policy, then the generic one
+template <class Policy>
+void measurePolicy(int policyIndex, const vector<soundpacking::Item<uint32_t, int32_t>>& items32,
+    const vector<soundpacking::Item<uint32_t, int64_t>>& items64, int capacity, int repeat, vector<PolicyResult>& results)
+{
+    string name = policyNames[policyIndex];
+    results.push_back(measure<Policy>(name, "int32", items32, (int32_t)capacity, repeat));
+    results.push_back(measure<Policy>(name, "int64", items64, (int64_t)capacity, repeat));
+    runtimePolicy = policyIndex;
+    results.push_back(measure<RuntimePolicy>(name, "generic", items64, (int64_t)capacity, repeat));
+}
+
+
+
+//########################### MAIN ###################################
+
+int main(int argc, char* argv[])
+{
+    CatalogSpec spec;
+    spec.files = 1000000;
+    int repeat = 5;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string argument = argv[i];
+        size_t equals = argument.find('=');
+        string name = argument.substr(0, equals);
+        string value = equals == string::npos ? "" : argument.substr(equals + 1);
+        bool number = !value.empty() && value.find_first_not_of("0123456789") == string::npos;
+        bool valid = false;
+
+        if (name == "--files" || name == "--capacity" || name == "--repeat")
+        {
+            valid = number && stoll(value) > 0 && stoll(value) <= INT32_MAX;
+            if (valid) (name == "--files" ? spec.files : name == "--capacity" ? spec.capacity : repeat) = stoi(value);
+        }
+        else if (name == "--seed")
+        {
+            valid = number;
+            if (valid) spec.seed = stoull(value);
+        }
+        else if (name == "--distribution")
+        {
+            valid = parseDistribution(value, spec.distribution);
+        }
+
+        if (!valid)
+        {
+            cerr << "Unknown option: " << argument << endl;
+            cerr << "Options: --files=N, --capacity=SECONDS, --seed=N, --repeat=N" << endl;
+            cerr << "         --distribution=uniform|heavy-tailed|duplicates|near-capacity" << endl;
+            return 1;
+        }
+    }
+
+    vector<int> durations = generateDurations(spec);
+    vector<soundpacking::Item<uint32_t, int32_t>> items32(durations.size());
+    vector<soundpacking::Item<uint32_t, int64_t>> items64(durations.size());
+    for (size_t i = 0; i < durations.size(); i++)
+    {
+        items32[i] = { (uint32_t)i, durations[i] };
+        items64[i] = { (uint32_t)i, durations[i] };
+    }
+
+    vector<PolicyResult> results;
+    measurePolicy<soundpacking::FirstFit>(0, items32, items64, spec.capacity, repeat, results);
+    measurePolicy<soundpacking::WorstFit>(1, items32, items64, spec.capacity, repeat, results);
+    measurePolicy<soundpacking::BestFit>(2, items32, items64, spec.capacity, repeat, results);
+    measurePolicy<soundpacking::WorstFitBuckets>(3, items32, items64, spec.capacity, repeat, results);
+    measurePolicy<soundpacking::BestFitBuckets>(4, items32, items64, spec.capacity, repeat, results);
+
+    cout << spec.files << " items (" << distributionNames[(int)spec.distribution] << ", seed " << spec.seed
+        << "), capacity " << spec.capacity << ", median of " << repeat << "\n\n";
+    cout << left << setw(18) << "policy" << setw(10) << "variant" << right << setw(12) << "ms" << setw(12) << "ns/item"
+        << setw(12) << "vs int32" << setw(10) << "folders" << "\n";
+    bool consistent = true;
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const PolicyResult& result = results[i];
+        const PolicyResult& specialized = results[i - i % 3];
+        consistent = consistent && result.folders == specialized.folders;
+        cout << left << setw(18) << result.policy << setw(10) << result.variant << right << fixed << setprecision(2)
+            << setw(12) << result.medianMilliseconds << setw(12) << result.medianMilliseconds * 1e6 / max(1, spec.files)
+            << setw(11) << result.medianMilliseconds / max(1e-9, specialized.medianMilliseconds) << "x"
+            << setw(10) << result.folders << "\n";
+    }
+    if (!consistent)
+    {
+        cerr << "Error: the instantiations of a policy packed different folder counts" << endl;
+        return 1;
+    }
+    return 0;
+}
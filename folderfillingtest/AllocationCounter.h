@@ -0,0 +1,53 @@
+#pragma once
+// Counts the heap allocations of every thread. the whole set of global operator new and delete
+// (plain, array, sized and nothrow) is replaced together and served by malloc and free, so every block
+// is freed by the allocator it came from whatever the C++ runtime does by default (the MSVC debug heap).
+// the over-aligned variants are left to the runtime, they allocate and free among themselves.
+// replacement functions are defined once per program: include this in a single translation unit
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// operator new calls of the thread so far, the caller counts the difference over the work it measures
+inline thread_local long long threadAllocations = 0;
+
+// (not inlined, GCC would take every malloc it sees paired with operator delete for a mismatch)
+#ifdef __GNUC__
+__attribute__((noinline))
+#endif
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    threadAllocations++;
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size)
+{
+    if (void* block = operator new(size, std::nothrow)) return block;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return operator new(size, std::nothrow);
+}
+
+#ifdef __GNUC__
+__attribute__((noinline))
+#endif
+void operator delete(void* block) noexcept
+{
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept { operator delete(block); }
+void operator delete(void* block, std::size_t) noexcept { operator delete(block); }
+void operator delete[](void* block, std::size_t) noexcept { operator delete(block); }
+void operator delete(void* block, const std::nothrow_t&) noexcept { operator delete(block); }
+void operator delete[](void* block, const std::nothrow_t&) noexcept { operator delete(block); }
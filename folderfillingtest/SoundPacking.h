@@ -0,0 +1,1537 @@
+#pragma once
+// Header-only library of the packing engines: the placement part of the program without its
+// "Sample Tests" paths, console output or I/O, for any key type, duration type and allocator.
+// it also holds the folder filling engines (a subset sum per folder over int durations, the engine
+// is a policy too) and the lower bounds on the folder count.
+//
+//   std::vector<soundpacking::Item<std::string, int64_t>> items = ...;
+//   auto packing = soundpacking::pack<soundpacking::BestFitDecreasing>(items, capacity);
+//   for (size_t f = 0; f < packing.folders.size(); f++) ... packing.folders[f], packing.remaining[f]
+//
+// the placement policy is a template argument: its index is a concrete type, so the placement loop
+// is compiled once per policy and inlines completely (no std::function, no virtual call).
+// "Buckets" policies keep one bucket per capacity value (integral durations, O(capacity) memory)
+// and find a folder in O(log64 C), the others take any signed duration and find it in O(log m)
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define SOUND_PACKING_X86
+#endif
+
+namespace soundpacking {
+
+template <class Allocator, class T>
+using Rebind = typename std::allocator_traits<Allocator>::template rebind_alloc<T>;
+
+// what take() returns when no open folder fits
+constexpr size_t noFolder = std::numeric_limits<size_t>::max();
+
+namespace detail {
+template <class T> struct Identity { using type = T; };    // keeps a parameter out of deduction
+}
+
+
+//########################### BITMAPS ###################################
+
+// index of the lowest set bit of a non zero 64-bit word
+inline int lowestBit(uint64_t word)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward64(&index, word);
+    return (int)index;
+#else
+    return __builtin_ctzll(word);
+#endif
+}
+
+// index of the highest set bit of a non zero 64-bit word
+inline int highestBit(uint64_t word)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse64(&index, word);
+    return (int)index;
+#else
+    return 63 - __builtin_clzll(word);
+#endif
+}
+
+// hierarchical bitmap over [0, size): each level has one bit per 64-bit word of the level below
+// (van Emde Boas style), so the next set bit after a position, or the highest one,
+// takes O(log64 size), a few word operations
+template <class Allocator = std::allocator<uint64_t>>
+struct LevelBitmap {
+    using Words = std::vector<uint64_t, Rebind<Allocator, uint64_t>>;
+    std::vector<Words, Rebind<Allocator, Words>> levels;   // levels[0] has one bit per position
+
+    explicit LevelBitmap(size_t size, const Allocator& allocator = Allocator()) //O(size/64)
+        : levels(Rebind<Allocator, Words>(allocator))
+    {
+        size_t bits = size;
+        do {
+            size_t words = (bits + 63) / 64;
+            levels.push_back(Words(words, 0, Rebind<Allocator, uint64_t>(allocator)));
+            bits = words;
+        } while (bits > 1);
+    }
+
+    void set(size_t pos) //O(log64 size)
+    {
+        for (auto& level : levels) {
+            uint64_t& word = level[pos / 64];
+            bool wasEmpty = (word == 0);
+            word |= 1ULL << (pos % 64);
+            if (!wasEmpty) break; // upper levels already know about this word
+            pos /= 64;
+        }
+    }
+
+    void reset(size_t pos) //O(log64 size)
+    {
+        for (auto& level : levels) {
+            uint64_t& word = level[pos / 64];
+            word &= ~(1ULL << (pos % 64));
+            if (word != 0) break; // word still has other bits, upper levels stay set
+            pos /= 64;
+        }
+    }
+
+    // smallest set position >= pos, -1 if there is none
+    int successor(size_t pos) const //O(log64 size)
+    {
+        size_t level = 0;
+
+        // climb until a word has a set bit at or after pos
+        while (true) {
+            if (level == levels.size()) return -1;
+            size_t wordIndex = pos / 64;
+            if (wordIndex >= levels[level].size()) return -1;
+            uint64_t word = levels[level][wordIndex] & (~0ULL << (pos % 64));
+            if (word != 0) {
+                pos = wordIndex * 64 + lowestBit(word);
+                break;
+            }
+            pos = wordIndex + 1; // first word after this one, as a bit of the upper level
+            level++;
+        }
+
+        // descend taking the lowest set bit at each level
+        while (level > 0) {
+            level--;
+            pos = pos * 64 + lowestBit(levels[level][pos]);
+        }
+        return (int)pos;
+    }
+
+    // highest set position, -1 if nothing is set
+    int highest() const //O(log64 size)
+    {
+        size_t level = levels.size() - 1; // the top level is a single word
+        if (levels[level][0] == 0) return -1;
+        size_t pos = highestBit(levels[level][0]);
+        while (level > 0) {
+            level--;
+            pos = pos * 64 + highestBit(levels[level][pos]);
+        }
+        return (int)pos;
+    }
+};
+
+// folders by remaining capacity (0 to capacity), a bucket of folder indexes per value
+// and a LevelBitmap of the non empty buckets
+template <class Allocator = std::allocator<int>>
+struct CapacityIndex {
+    using Bucket = std::vector<int, Rebind<Allocator, int>>;
+    std::vector<Bucket, Rebind<Allocator, Bucket>> buckets;    // buckets[r] = folders whose remaining capacity is r
+    LevelBitmap<Rebind<Allocator, uint64_t>> nonEmpty;          // bit r is set when buckets[r] has a folder
+
+    explicit CapacityIndex(int capacity, const Allocator& allocator = Allocator()) //O(capacity)
+        : buckets(capacity + 1, Bucket(Rebind<Allocator, int>(allocator)), Rebind<Allocator, Bucket>(allocator)),
+        nonEmpty(capacity + 1, Rebind<Allocator, uint64_t>(allocator))
+    {
+    }
+
+    void insert(int folderIndex, int remainingCapacity) //O(log64 capacity)
+    {
+        buckets[remainingCapacity].push_back(folderIndex);
+        if (buckets[remainingCapacity].size() == 1) nonEmpty.set(remainingCapacity);
+    }
+
+    // removes and returns the most recently inserted folder of the bucket
+    int take(int remainingCapacity) //O(log64 capacity)
+    {
+        Bucket& bucket = buckets[remainingCapacity];
+        int folderIndex = bucket.back();
+        bucket.pop_back();
+        if (bucket.empty()) nonEmpty.reset(remainingCapacity);
+        return folderIndex;
+    }
+
+    // smallest remaining capacity >= duration that has a folder, -1 if there is none
+    int successor(int duration) const //O(log64 capacity)
+    {
+        return nonEmpty.successor(duration);
+    }
+
+    // removes a given folder, wherever it is in its bucket
+    void erase(int folderIndex, int remainingCapacity) //O(bucket size + log64 capacity)
+    {
+        Bucket& bucket = buckets[remainingCapacity];
+        *std::find(bucket.begin(), bucket.end(), folderIndex) = bucket.back();
+        bucket.pop_back();
+        if (bucket.empty()) nonEmpty.reset(remainingCapacity);
+    }
+};
+
+
+//########################### FOLDER INDEXES ###################################
+
+// every policy has an Index over the open folders with the same three operations:
+//   take(duration)            a folder the item goes to (removed from the index), noFolder if none fits
+//   put(folder, remaining)    a folder that got an item, new or taken, with its remaining capacity
+//   operations()              index nodes visited or updated so far
+// a folder whose remaining capacity went negative (an item longer than the capacity) is never taken again
+
+namespace detail {
+
+// complete binary tree over folder slots, an inner node holds the largest remaining capacity below it.
+// slots not opened yet hold the lowest duration so nothing is ever placed there
+template <class Duration, class Allocator>
+struct MaxTree {
+    std::vector<Duration, Rebind<Allocator, Duration>> tree;   // tree[1] is the root, leaves start at tree[leaves]
+    size_t leaves = 1;
+    long long operations = 0;
+
+    MaxTree(size_t slots, const Allocator& allocator) : tree(Rebind<Allocator, Duration>(allocator)) //O(slots)
+    {
+        while (leaves < slots) leaves *= 2;
+        tree.assign(2 * leaves, std::numeric_limits<Duration>::lowest());
+    }
+
+    Duration top() const { return tree[1]; }
+
+    // leftmost slot holding at least duration, the root must hold at least duration
+    size_t leftmostAtLeast(Duration duration) //O(log m)
+    {
+        size_t node = 1;
+        while (node < leaves) {
+            node = (tree[2 * node] >= duration) ? 2 * node : 2 * node + 1;
+            operations++;
+        }
+        return node - leaves;
+    }
+
+    void set(size_t slot, Duration value) //O(log m)
+    {
+        size_t node = leaves + slot;
+        tree[node] = value;
+        for (node /= 2; node >= 1; node /= 2) {
+            tree[node] = std::max(tree[2 * node], tree[2 * node + 1]);
+            operations++;
+        }
+    }
+};
+
+}
+
+// First-Fit: the lowest folder that fits, a tournament tree of remaining capacities
+//TIME COMPLEXITY: O(log m) per item
+template <class Duration, class Allocator>
+struct FirstFitIndex {
+    detail::MaxTree<Duration, Allocator> tree;
+
+    FirstFitIndex(size_t items, Duration, const Allocator& allocator) : tree(items, allocator) {}
+
+    size_t take(Duration duration) { return tree.top() >= duration ? tree.leftmostAtLeast(duration) : noFolder; }
+    void put(size_t folder, Duration remaining) { tree.set(folder, remaining); }
+    long long operations() const { return tree.operations; }
+};
+
+// Worst-Fit: the folder with the most capacity left, the lowest one among equals
+//TIME COMPLEXITY: O(log m) per item
+template <class Duration, class Allocator>
+struct WorstFitIndex {
+    detail::MaxTree<Duration, Allocator> tree;
+
+    WorstFitIndex(size_t items, Duration, const Allocator& allocator) : tree(items, allocator) {}
+
+    size_t take(Duration duration) { return tree.top() >= duration ? tree.leftmostAtLeast(tree.top()) : noFolder; }
+    void put(size_t folder, Duration remaining) { tree.set(folder, remaining); }
+    long long operations() const { return tree.operations; }
+};
+
+// Best-Fit: the folder with the least capacity left that still fits, the latest one among equals,
+// an ordered set of (remaining, -insertion, folder)
+//TIME COMPLEXITY: O(log m) per item
+template <class Duration, class Allocator>
+struct BestFitIndex {
+    using Entry = std::tuple<Duration, long long, size_t>;
+    std::set<Entry, std::less<Entry>, Rebind<Allocator, Entry>> folders;
+    long long insertions = 0, visited = 0;
+
+    BestFitIndex(size_t, Duration, const Allocator& allocator) : folders(Rebind<Allocator, Entry>(allocator)) {}
+
+    size_t take(Duration duration)
+    {
+        auto tightest = folders.lower_bound(Entry(duration, std::numeric_limits<long long>::min(), 0));
+        if (tightest == folders.end()) return noFolder;
+        size_t folder = std::get<2>(*tightest);
+        folders.erase(tightest);
+        visited++;
+        return folder;
+    }
+
+    void put(size_t folder, Duration remaining)
+    {
+        if (remaining < 0) return;
+        folders.emplace(remaining, -++insertions, folder);
+        visited++;
+    }
+
+    long long operations() const { return visited; }
+};
+
+// First-Fit over a plain list of remaining capacities, scanned from the first folder
+//TIME COMPLEXITY: O(m) per item
+template <class Duration, class Allocator>
+struct FirstFitLinearIndex {
+    std::vector<Duration, Rebind<Allocator, Duration>> remaining;
+    long long scanned = 0;
+
+    FirstFitLinearIndex(size_t, Duration, const Allocator& allocator) : remaining(Rebind<Allocator, Duration>(allocator)) {}
+
+    size_t take(Duration duration)
+    {
+        for (size_t folder = 0; folder < remaining.size(); folder++) {
+            scanned++;
+            if (duration <= remaining[folder]) return folder;
+        }
+        return noFolder;
+    }
+
+    void put(size_t folder, Duration left)
+    {
+        if (folder == remaining.size()) remaining.push_back(left);
+        else remaining[folder] = left;
+    }
+
+    long long operations() const { return scanned; }
+};
+
+// Worst-Fit over a plain list of remaining capacities, every folder is looked at for every item
+// (the same folders as WorstFitIndex)
+//TIME COMPLEXITY: O(m) per item
+template <class Duration, class Allocator>
+struct WorstFitLinearIndex {
+    std::vector<Duration, Rebind<Allocator, Duration>> remaining;
+    long long scanned = 0;
+
+    WorstFitLinearIndex(size_t, Duration, const Allocator& allocator) : remaining(Rebind<Allocator, Duration>(allocator)) {}
+
+    size_t take(Duration duration)
+    {
+        size_t most = noFolder;
+        scanned += remaining.size();
+        for (size_t folder = 0; folder < remaining.size(); folder++) {
+            if (remaining[folder] >= duration && (most == noFolder || remaining[folder] > remaining[most])) most = folder;
+        }
+        return most;
+    }
+
+    void put(size_t folder, Duration left)
+    {
+        if (folder == remaining.size()) remaining.push_back(left);
+        else remaining[folder] = left;
+    }
+
+    long long operations() const { return scanned; }
+};
+
+// Worst-Fit over a binary max-heap of (remaining, folder), like std::priority_queue: the top folder
+// takes the item when it fits. among equals the heap decides, the folder count is the one of WorstFitIndex
+//TIME COMPLEXITY: O(log m) per item
+template <class Duration, class Allocator>
+struct WorstFitHeapIndex {
+    struct Entry {
+        Duration remaining;
+        size_t folder;
+    };
+    std::vector<Entry, Rebind<Allocator, Entry>> heap;
+    long long heapOperations = 0;
+
+    WorstFitHeapIndex(size_t, Duration, const Allocator& allocator) : heap(Rebind<Allocator, Entry>(allocator)) {}
+
+    static bool less(const Entry& a, const Entry& b) { return a.remaining < b.remaining; }
+
+    size_t take(Duration duration)
+    {
+        if (heap.empty() || heap.front().remaining < duration) return noFolder;
+        std::pop_heap(heap.begin(), heap.end(), less);
+        size_t folder = heap.back().folder;
+        heap.pop_back();
+        heapOperations++;
+        return folder;
+    }
+
+    // a folder that went negative stays in the heap, below every folder an item can take
+    void put(size_t folder, Duration remaining)
+    {
+        heap.push_back({ remaining, folder });
+        std::push_heap(heap.begin(), heap.end(), less);
+        heapOperations++;
+    }
+
+    long long operations() const { return heapOperations; }
+};
+
+// Worst-Fit over capacity buckets: the highest non empty bucket, a min-heap of folder indexes
+// per bucket gives the lowest folder among equals (the same folders as WorstFitIndex)
+//TIME COMPLEXITY: O(log64 C + log m) per item
+template <class Duration, class Allocator>
+struct WorstFitBucketIndex {
+    static_assert(std::is_integral<Duration>::value, "capacity buckets need integral durations");
+    using Bucket = std::vector<size_t, Rebind<Allocator, size_t>>;
+    std::vector<Bucket, Rebind<Allocator, Bucket>> buckets;
+    LevelBitmap<Rebind<Allocator, uint64_t>> nonEmpty;
+    long long heapOperations = 0;
+
+    WorstFitBucketIndex(size_t, Duration capacity, const Allocator& allocator) //O(C)
+        : buckets((size_t)capacity + 1, Bucket(Rebind<Allocator, size_t>(allocator)), Rebind<Allocator, Bucket>(allocator)),
+        nonEmpty((size_t)capacity + 1, Rebind<Allocator, uint64_t>(allocator))
+    {
+    }
+
+    size_t take(Duration duration)
+    {
+        int most = nonEmpty.highest();
+        if (most < 0 || (Duration)most < duration) return noFolder;
+        Bucket& bucket = buckets[most];
+        std::pop_heap(bucket.begin(), bucket.end(), std::greater<size_t>());
+        size_t folder = bucket.back();
+        bucket.pop_back();
+        if (bucket.empty()) nonEmpty.reset(most);
+        heapOperations++;
+        return folder;
+    }
+
+    void put(size_t folder, Duration remaining)
+    {
+        if (remaining < 0) return;
+        Bucket& bucket = buckets[(size_t)remaining];
+        bucket.push_back(folder);
+        std::push_heap(bucket.begin(), bucket.end(), std::greater<size_t>());
+        nonEmpty.set((size_t)remaining);
+        heapOperations++;
+    }
+
+    long long operations() const { return heapOperations; }
+};
+
+// Best-Fit over capacity buckets: the next non empty bucket at or above the duration,
+// the latest folder of the bucket (the same folders as BestFitIndex).
+// the CapacityIndex holds ints: the capacity and the folder indexes (at most one folder per item) must fit in one
+//TIME COMPLEXITY: O(log64 C) per item
+template <class Duration, class Allocator>
+struct BestFitBucketIndex {
+    static_assert(std::is_integral<Duration>::value, "capacity buckets need integral durations");
+    CapacityIndex<Rebind<Allocator, int>> index;
+    long long visited = 0;
+
+    BestFitBucketIndex(size_t items, Duration capacity, const Allocator& allocator) //O(C)
+        : index(checkedCapacity(items, capacity), Rebind<Allocator, int>(allocator))
+    {
+    }
+
+    static int checkedCapacity(size_t items, Duration capacity)
+    {
+        bool capacityFits = true;
+        if constexpr (sizeof(Duration) >= sizeof(int)) capacityFits = capacity <= (Duration)INT_MAX;
+        if (!capacityFits || items > (size_t)INT_MAX)
+            throw std::length_error("BestFitBuckets: the capacity and the folder indexes must fit in an int");
+        return (int)capacity;
+    }
+
+    size_t take(Duration duration)
+    {
+        int tightest = index.successor((int)duration);
+        if (tightest == -1) return noFolder;
+        visited++;
+        return index.take(tightest);
+    }
+
+    void put(size_t folder, Duration remaining)
+    {
+        if (remaining < 0) return;
+        index.insert((int)folder, (int)remaining);
+        visited++;
+    }
+
+    long long operations() const { return visited; }
+};
+
+
+//########################### POLICIES ###################################
+
+struct FirstFit {
+    static constexpr bool decreasing = false;
+    template <class Duration, class Allocator> using Index = FirstFitIndex<Duration, Allocator>;
+};
+
+struct WorstFit {
+    static constexpr bool decreasing = false;
+    template <class Duration, class Allocator> using Index = WorstFitIndex<Duration, Allocator>;
+};
+
+struct BestFit {
+    static constexpr bool decreasing = false;
+    template <class Duration, class Allocator> using Index = BestFitIndex<Duration, Allocator>;
+};
+
+struct FirstFitLinear {
+    static constexpr bool decreasing = false;
+    template <class Duration, class Allocator> using Index = FirstFitLinearIndex<Duration, Allocator>;
+};
+
+struct WorstFitLinear {
+    static constexpr bool decreasing = false;
+    template <class Duration, class Allocator> using Index = WorstFitLinearIndex<Duration, Allocator>;
+};
+
+struct WorstFitHeap {
+    static constexpr bool decreasing = false;
+    template <class Duration, class Allocator> using Index = WorstFitHeapIndex<Duration, Allocator>;
+};
+
+struct WorstFitBuckets {
+    static constexpr bool decreasing = false;
+    template <class Duration, class Allocator> using Index = WorstFitBucketIndex<Duration, Allocator>;
+};
+
+struct BestFitBuckets {
+    static constexpr bool decreasing = false;
+    template <class Duration, class Allocator> using Index = BestFitBucketIndex<Duration, Allocator>;
+};
+
+// the same placement over the items sorted by decreasing duration (stable, equal items keep their order)
+template <class Policy>
+struct Decreasing : Policy {
+    static constexpr bool decreasing = true;
+};
+
+using FirstFitDecreasing = Decreasing<FirstFit>;
+using WorstFitDecreasing = Decreasing<WorstFit>;
+using BestFitDecreasing = Decreasing<BestFit>;
+using FirstFitLinearDecreasing = Decreasing<FirstFitLinear>;
+using WorstFitLinearDecreasing = Decreasing<WorstFitLinear>;
+using WorstFitHeapDecreasing = Decreasing<WorstFitHeap>;
+using WorstFitBucketsDecreasing = Decreasing<WorstFitBuckets>;
+using BestFitBucketsDecreasing = Decreasing<BestFitBuckets>;
+
+
+//########################### FOLDER TABLE ###################################
+
+// a view of count contiguous elements (the keys of one folder), converts from a vector
+template <class T>
+struct Span {
+    T* first = nullptr;
+    size_t count = 0;
+
+    Span() = default;
+    Span(T* first, size_t count) : first(first), count(count) {}
+    template <class Vector, typename std::enable_if<std::is_convertible<decltype(std::declval<Vector&>().data()), T*>::value, int>::type = 0>
+    Span(Vector& vector) : first(vector.data()), count(vector.size()) {}
+
+    T* data() const { return first; }
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    T* begin() const { return first; }
+    T* end() const { return first + count; }
+    T& operator[](size_t i) const { return first[i]; }
+};
+
+// the folders of a packing as compressed sparse rows: folder f holds keys[offsets[f], offsets[f + 1]).
+// two arrays whatever the number of folders, instead of one vector per folder
+template <class Key, class Allocator = std::allocator<Key>>
+struct FolderTable {
+    std::vector<size_t, Rebind<Allocator, size_t>> offsets;     // folders + 1 entries, offsets[0] = 0
+    std::vector<Key, Rebind<Allocator, Key>> keys;
+
+    explicit FolderTable(const Allocator& allocator = Allocator())
+        : offsets(1, 0, Rebind<Allocator, size_t>(allocator)), keys(Rebind<Allocator, Key>(allocator)) {}
+
+    Allocator get_allocator() const { return Allocator(keys.get_allocator()); }
+    size_t size() const { return offsets.size() - 1; }
+    bool empty() const { return offsets.size() == 1; }
+    Span<const Key> operator[](size_t folder) const { return { keys.data() + offsets[folder], offsets[folder + 1] - offsets[folder] }; }
+
+    void reserve(size_t folders, size_t count)
+    {
+        offsets.reserve(folders + 1);
+        keys.reserve(count);
+    }
+
+    void clear()
+    {
+        offsets.assign(1, 0);
+        keys.clear();
+    }
+
+    // keys pushed since the last closeFolder() make the next folder
+    void push_back(const Key& key) { keys.push_back(key); }
+    size_t pending() const { return keys.size() - offsets.back(); }
+    void closeFolder() { offsets.push_back(keys.size()); }
+
+    template <class Iterator>
+    void appendFolder(Iterator first, Iterator last)
+    {
+        keys.insert(keys.end(), first, last);
+        closeFolder();
+    }
+
+    // rebuilds the table from the key and the folder of "count" placements (a counting sort),
+    // keys keep their placement order inside a folder
+    //TIME COMPLEXITY: θ(count + folders)
+    template <class KeyOf, class FolderOf>
+    void assign(size_t folders, size_t count, KeyOf keyOf, FolderOf folderOf)
+    {
+        offsets.assign(folders + 1, 0);
+        for (size_t i = 0; i < count; i++) offsets[folderOf(i)]++;
+        for (size_t f = 1; f <= folders; f++) offsets[f] += offsets[f - 1];    // offsets[f] is now the end of folder f
+        keys.resize(count);
+        for (size_t i = count; i-- > 0; ) keys[--offsets[folderOf(i)]] = keyOf(i); // back to front, ends move to starts
+    }
+};
+
+
+//########################### PACKING ###################################
+
+template <class Key, class Duration>
+struct Item {
+    Key key;
+    Duration duration;
+};
+
+// the folders of a packing in the order they were opened, keys in placement order
+template <class Key, class Duration, class Allocator = std::allocator<Key>>
+struct Packing {
+    FolderTable<Key, Allocator> folders;
+    std::vector<Duration, Rebind<Allocator, Duration>> remaining;  // capacity left per folder, negative for one with an item longer than the capacity
+    long long operations = 0;       // index nodes visited or updated to place the items
+
+    explicit Packing(const Allocator& allocator = Allocator()) : folders(allocator), remaining(Rebind<Allocator, Duration>(allocator)) {}
+};
+
+// places every item in a folder of the given capacity following Policy
+//TIME COMPLEXITY: n times the index of the policy (+ O(n log n) for a decreasing policy)
+template <class Policy, class Key, class Duration, class Allocator = std::allocator<Key>>
+Packing<Key, Duration, Allocator> pack(const Item<Key, Duration>* items, size_t count,
+    typename detail::Identity<Duration>::type capacity, const Allocator& allocator = Allocator())
+{
+    static_assert(std::is_signed<Duration>::value, "durations must be signed, a folder with an item longer than the capacity goes negative");
+    Packing<Key, Duration, Allocator> packing(allocator);
+    typename Policy::template Index<Duration, Allocator> index(count, capacity, allocator);
+
+    // the folder of every placement, the keys are gathered into the table once they are all placed
+    std::vector<size_t, Rebind<Allocator, size_t>> folderOf(count, 0, Rebind<Allocator, size_t>(allocator));
+    size_t placed = 0;
+    auto place = [&](const Item<Key, Duration>& item) {
+        size_t folder = (item.duration <= capacity) ? index.take(item.duration) : noFolder;
+        if (folder == noFolder) {
+            folder = packing.remaining.size();
+            packing.remaining.push_back(capacity);
+        }
+        packing.remaining[folder] -= item.duration;
+        index.put(folder, packing.remaining[folder]);
+        folderOf[placed++] = folder;
+    };
+    auto folderOfPlacement = [&](size_t i) { return folderOf[i]; };
+
+    if constexpr (Policy::decreasing) {
+        std::vector<size_t, Rebind<Allocator, size_t>> order(count, 0, Rebind<Allocator, size_t>(allocator));
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::stable_sort(order.begin(), order.end(), [items](size_t a, size_t b) { return items[a].duration > items[b].duration; });
+        for (size_t i : order) place(items[i]);
+        packing.folders.assign(packing.remaining.size(), count, [&](size_t i) { return items[order[i]].key; }, folderOfPlacement);
+    }
+    else {
+        for (size_t i = 0; i < count; i++) place(items[i]);
+        packing.folders.assign(packing.remaining.size(), count, [&](size_t i) { return items[i].key; }, folderOfPlacement);
+    }
+    packing.operations = index.operations();
+    return packing;
+}
+
+template <class Policy, class Key, class Duration, class ItemAllocator, class Allocator = std::allocator<Key>>
+Packing<Key, Duration, Allocator> pack(const std::vector<Item<Key, Duration>, ItemAllocator>& items,
+    typename detail::Identity<Duration>::type capacity, const Allocator& allocator = Allocator())
+{
+    return pack<Policy>(items.data(), items.size(), capacity, allocator);
+}
+
+
+//########################### LOWER BOUNDS ###################################
+
+// lower bounds on the folder count of any packing, a packing that meets one is optimal.
+// l1 = ceil(total duration / capacity).
+// l2 is the Martello-Toth bound, the best over every k <= C/2 of:
+//   files longer than C-k, nothing of k or more fits next to them
+//   + files in (C/2, C-k], one folder each
+//   + whatever the files in [k, C/2] need once they filled the room left next to the (C/2, C-k] ones.
+// l2 >= l1, only k = 0 and the distinct durations up to C/2 have to be tried
+struct LowerBounds {
+    long long l1 = 0;
+    long long l2 = 0;
+
+    long long best() const { return std::max(l1, l2); }
+};
+
+// the bounds of count durations sorted in decreasing order
+//TIME COMPLEXITY: O(n + d log n) where d is the number of distinct durations up to C/2
+template <class Duration>
+LowerBounds lowerBounds(const Duration* sortedDurations, size_t count, typename detail::Identity<Duration>::type capacity)
+{
+    LowerBounds bounds;
+    size_t n = count;
+    if (n == 0 || capacity <= 0) return bounds;
+
+    // increasing durations with prefix sums, prefix[i] is the sum of the first i
+    std::vector<long long> durations(n), prefix(n + 1, 0);
+    for (size_t i = 0; i < n; i++) { //θ(n)
+        durations[i] = sortedDurations[n - 1 - i];
+        prefix[i + 1] = prefix[i] + durations[i];
+    }
+    long long c = capacity;
+    bounds.l1 = (prefix[n] + c - 1) / c;
+
+    auto firstAbove = [&](long long duration) { //O(log n)
+        return size_t(std::upper_bound(durations.begin(), durations.end(), duration) - durations.begin());
+    };
+    size_t half = firstAbove(c / 2);    // files from here on are longer than C/2, one folder each
+
+    auto boundFor = [&](long long k) { //O(log n)
+        size_t large = firstAbove(c - k);                                                           // (C-k, ...]
+        size_t small = size_t(std::lower_bound(durations.begin(), durations.end(), k) - durations.begin()); // [k, C/2]
+        long long room = (long long)(large - half) * c - (prefix[large] - prefix[half]);
+        long long overflow = (prefix[half] - prefix[small]) - room;
+        return (long long)(n - half) + (overflow > 0 ? (overflow + c - 1) / c : 0);
+    };
+
+    bounds.l2 = boundFor(0);
+    for (size_t i = 0; i < half; i++) { //O(d log n)
+        if (i == 0 || durations[i] != durations[i - 1])
+            bounds.l2 = std::max(bounds.l2, boundFor(durations[i]));
+    }
+    return bounds;
+}
+
+template <class Duration, class Allocator>
+LowerBounds lowerBounds(const std::vector<Duration, Allocator>& sortedDurations, typename detail::Identity<Duration>::type capacity)
+{
+    return lowerBounds(sortedDurations.data(), sortedDurations.size(), capacity);
+}
+
+
+//########################### FOLDER FILLING ###################################
+
+// folder filling: every folder takes the max total duration that fits among the items left, one subset sum
+// per folder over int durations. the subset-sum engine is the policy, every engine has:
+//   solve(durations, reusable)    the max total duration <= capacity of the durations; the first reusable
+//                                 durations are the ones of the last call (rows up to them are still valid)
+//   backtrack(durations, chosen)  the items of that total, pushed into chosen as decreasing indexes
+//   record(stats)                 adds what the last solve and backtrack did to the stats
+//   name()                        for reports
+// all of them pick exactly the items the table picks (the sparse engine as long as it stays in its state budget)
+
+// what folder filling measured besides the folders
+struct FolderFillingStats {
+    std::string engineName;
+    long long packNanoseconds = 0;      // subset sums and backtracking only
+    long long backtrackNanoseconds = 0;
+    long long folderSolves = 0;         // subset sums solved, one per folder
+    size_t dpMemoryBytes = 0;           // peak
+    long long cells = 0;                // cells evaluated, a bit of a bitset row and a sparse state count as one
+    long long reusedCells = 0, recomputedCells = 0;
+    bool aborted = false;               // stopped before every item was in a folder
+    int meetInTheMiddleFolders = 0;     // sparse engine: folders solved exactly by meet in the middle
+    int approximateFolders = 0;         // sparse engine: folders within epsilon of the best duration only
+    double maxEpsilon = 0;
+    int durationClasses = 0;            // duration classes: distinct durations
+};
+
+// the full (n+1)*(C+1) table, bottom up: table[i][j] is the max total <= j of the first i items.
+// row i only depends on items 0..i-1, so rows up to the first item removed are kept from the last folder
+template <class Allocator = std::allocator<int>>
+struct TableSubsetSum {
+    using allocator_type = Allocator;
+    using Row = std::vector<int, Rebind<Allocator, int>>;
+    int capacity;
+    std::vector<Row, Rebind<Allocator, Row>> table;
+    int reusedRows = 0, recomputedRows = 0;     // by the last solve()
+
+    TableSubsetSum(int capacity, size_t items, const Allocator& allocator = Allocator()) //θ(n*C)
+        : capacity(capacity), table(items + 1, Row((size_t)capacity + 1, 0, Rebind<Allocator, int>(allocator)), Rebind<Allocator, Row>(allocator))
+    {
+    }
+
+    allocator_type get_allocator() const { return allocator_type(table.get_allocator()); }
+    std::string name() const { return "table"; }
+
+    //TIME COMPLEXITY: θ((n - reusable)*C)
+    template <class Durations>
+    int solve(const Durations& durations, int reusable)
+    {
+        int n = (int)durations.size();
+        for (int i = reusable; i <= n; i++) { //θ(n*C)
+            for (int j = 0; j <= capacity; j++) {
+                if (i == 0 || j == 0)   // no items left or no capacity
+                    table[i][j] = 0;
+                else if (durations[i - 1] <= j) // the item fits: the best of including or excluding it
+                    table[i][j] = std::max(table[i - 1][j], table[i - 1][j - durations[i - 1]] + durations[i - 1]);
+                else
+                    table[i][j] = table[i - 1][j];
+            }
+        }
+        reusedRows = std::min(reusable, n + 1);
+        recomputedRows = n + 1 - reusedRows;
+        return table[n][capacity];
+    }
+
+    // an item was taken where its row differs from the previous one
+    //TIME COMPLEXITY: θ(n)
+    template <class Durations, class Chosen>
+    void backtrack(const Durations& durations, Chosen& chosen) const
+    {
+        int remaining = capacity;
+        for (int i = (int)durations.size(); i > 0; --i) {
+            if (table[i][remaining] != table[i - 1][remaining]) {
+                chosen.push_back(i - 1);
+                remaining -= durations[i - 1];
+            }
+        }
+    }
+
+    void record(FolderFillingStats& stats) const
+    {
+        stats.dpMemoryBytes = std::max(stats.dpMemoryBytes, table.size() * ((size_t)capacity + 1) * sizeof(int));
+        stats.cells += (long long)recomputedRows * (capacity + 1);
+        stats.reusedCells += (long long)reusedRows * (capacity + 1);
+        stats.recomputedCells += (long long)recomputedRows * (capacity + 1);
+    }
+};
+
+namespace detail {
+
+// row |= row << shift over 64-bit words, this is one subset-sum step for a file of duration "shift".
+// words are walked from the top down so the same row can be used as source and destination.
+inline void shiftOrScalar(uint64_t* row, size_t words, int shift)
+{
+    size_t wordShift = shift / 64;
+    int bitShift = shift % 64;
+
+    for (size_t i = words; i-- > wordShift; ) {
+        uint64_t shifted = row[i - wordShift] << bitShift;
+        if (bitShift != 0 && i > wordShift)
+            shifted |= row[i - wordShift - 1] >> (64 - bitShift);
+        row[i] |= shifted;
+    }
+}
+
+#ifdef SOUND_PACKING_X86
+// same as shiftOrScalar, 4 words at a time.
+// each block loads everything it reads before storing, and stores only above what is still unread.
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx2")))
+#endif
+inline void shiftOrAVX2(uint64_t* row, size_t words, int shift)
+{
+    size_t wordShift = shift / 64;
+    int bitShift = shift % 64;
+    __m128i left = _mm_cvtsi32_si128(bitShift);
+    __m128i right = _mm_cvtsi32_si128(64 - bitShift); // shifting by 64 gives 0, no special case
+
+    size_t i = words;
+    while (i >= 4 && i - 4 >= wordShift + 1) {
+        i -= 4;
+        __m256i high = _mm256_loadu_si256((const __m256i*)(row + i - wordShift));
+        __m256i low = _mm256_loadu_si256((const __m256i*)(row + i - wordShift - 1));
+        __m256i current = _mm256_loadu_si256((const __m256i*)(row + i));
+        __m256i shifted = _mm256_or_si256(_mm256_sll_epi64(high, left), _mm256_srl_epi64(low, right));
+        _mm256_storeu_si256((__m256i*)(row + i), _mm256_or_si256(current, shifted));
+    }
+
+    // the lowest words (and short rows) fall back to the scalar loop
+    shiftOrScalar(row, i, shift);
+}
+
+inline bool cpuHasAVX2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osSavesYmm = (info[2] & (1 << 27)) && ((_xgetbv(0) & 6) == 6);
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && (info[1] & (1 << 5));
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+typedef void (*ShiftOrKernel)(uint64_t*, size_t, int);
+
+// the widest shift-or kernel this cpu supports
+inline ShiftOrKernel selectShiftOrKernel(const char*& kernelName)
+{
+#ifdef SOUND_PACKING_X86
+    if (cpuHasAVX2()) {
+        kernelName = "AVX2";
+        return shiftOrAVX2;
+    }
+#endif
+    kernelName = "scalar";
+    return shiftOrScalar;
+}
+
+}
+
+// Subset-sum over bitsets: bit j of row i is set when some of the first i items sum to exactly j.
+// since value equals duration, table[i][j] of the table is the highest set bit <= j of row i,
+// so rows of (C+1) bits replace rows of (C+1) ints (1/32 of the memory).
+// only every "stride"-th row is kept as a checkpoint (stride ~ sqrt(n)); backtracking rebuilds
+// one block of rows at a time from its checkpoint, so it picks exactly the items the table picks.
+template <class Allocator = std::allocator<int>>
+struct BitsetSubsetSum {
+    using allocator_type = Allocator;
+    using Row = std::vector<uint64_t, Rebind<Allocator, uint64_t>>;
+    int capacity;
+    size_t words;                                       // 64-bit words per row
+    int stride = 1;                                     // rows between two checkpoints
+    std::vector<Row, Rebind<Allocator, Row>> checkpoints;   // checkpoints[k] = row k*stride
+    Row lastRow;                                        // row n
+    std::vector<Row, Rebind<Allocator, Row>> block;     // rows of the block being backtracked
+    detail::ShiftOrKernel kernel;
+    const char* kernelName = "";
+    int reusedRows = 0;                                 // rows the last solve() took from checkpoints
+    int recomputedRows = 0;                             // rows the last solve() had to shift-or again
+    int items = 0;                                      // of the last solve()
+
+    explicit BitsetSubsetSum(int capacity, const Allocator& allocator = Allocator())
+        : capacity(capacity), words((size_t)capacity / 64 + 1), checkpoints(Rebind<Allocator, Row>(allocator)),
+        lastRow(Rebind<Allocator, uint64_t>(allocator)), block(Rebind<Allocator, Row>(allocator))
+    {
+        kernel = detail::selectShiftOrKernel(kernelName);
+    }
+
+    allocator_type get_allocator() const { return allocator_type(lastRow.get_allocator()); }
+    std::string name() const { return std::string("bitset (") + kernelName + " kernel)"; }
+
+    // adds an item of this duration to every reachable sum of row and drops sums above capacity
+    void addItem(Row& row, int duration) const //θ(C/64)
+    {
+        if (duration > capacity) return;
+        kernel(row.data(), words, duration);
+        row[words - 1] &= ~0ULL >> (63 - capacity % 64);
+    }
+
+    // highest reachable sum <= limit in row, this is table[i][limit] of the table
+    int maxBelow(const Row& row, int limit) const //O(C/64)
+    {
+        size_t wordIndex = limit / 64;
+        uint64_t word = row[wordIndex] & (~0ULL >> (63 - limit % 64));
+        while (word == 0) {
+            word = row[--wordIndex]; // bit 0 is always set, so this stops at word 0
+        }
+        return (int)(wordIndex * 64 + highestBit(word));
+    }
+
+    // forward pass, rows before reusable are unchanged since the last call, so the pass restarts
+    // from the last checkpoint among them instead of row 0 (stride is fixed by the first call)
+    //TIME COMPLEXITY: θ((n - reusable + stride)*C/64)
+    template <class Durations>
+    int solve(const Durations& durations, int reusable)
+    {
+        items = (int)durations.size();
+        if (checkpoints.empty()) {
+            stride = 1;
+            while ((long long)stride * stride < items) stride++;
+        }
+
+        // checkpoint k holds row k*stride, keep the ones below reusable
+        size_t validCheckpoints = reusable == 0 ? 0 : (reusable - 1) / stride + 1;
+        validCheckpoints = std::min(validCheckpoints, checkpoints.size());
+        int startRow = 0;
+        if (validCheckpoints == 0) {
+            checkpoints.clear();
+            lastRow.assign(words, 0);
+            lastRow[0] = 1; // empty set sums to 0
+        }
+        else {
+            // restart from the last valid checkpoint, the loop below stores it again
+            startRow = (int)(validCheckpoints - 1) * stride;
+            lastRow = checkpoints[validCheckpoints - 1];
+            checkpoints.resize(validCheckpoints - 1, Row(lastRow.get_allocator()));
+        }
+        reusedRows = startRow;
+        recomputedRows = items - startRow;
+
+        for (int i = startRow; i < items; i++) { //θ(n - startRow)
+            if (i % stride == 0) checkpoints.push_back(lastRow);
+            addItem(lastRow, durations[i]); //θ(C/64)
+        }
+        return maxBelow(lastRow, capacity);
+    }
+
+    // same walk as the table backtracking (i from n down to 1), rows rebuilt one block at a time
+    //TIME COMPLEXITY: θ(n*C/64) to rebuild the rows + O(n*C/64) for the lookups
+    template <class Durations, class Chosen>
+    void backtrack(const Durations& durations, Chosen& chosen)
+    {
+        int remaining = capacity;
+        for (int blockStart = (items - 1) / stride * stride; blockStart >= 0; blockStart -= stride) {
+            // rebuild rows blockStart .. blockEnd from the checkpoint
+            int blockEnd = std::min(blockStart + stride, items);
+            block.resize(stride + 1, Row(lastRow.get_allocator()));
+            block[0] = checkpoints[blockStart / stride];
+            for (int i = blockStart; i < blockEnd; i++) {
+                block[i - blockStart + 1] = block[i - blockStart];
+                addItem(block[i - blockStart + 1], durations[i]);
+            }
+
+            for (int i = blockEnd; i > blockStart; --i) {
+                // the item was taken where the row differs from the previous one
+                if (maxBelow(block[i - blockStart], remaining) != maxBelow(block[i - blockStart - 1], remaining)) {
+                    chosen.push_back(i - 1);
+                    remaining -= durations[i - 1];
+                }
+            }
+        }
+    }
+
+    // bytes held by checkpoints and the backtracking block
+    size_t memoryBytes() const
+    {
+        return (checkpoints.size() + stride + 2) * words * sizeof(uint64_t);
+    }
+
+    void record(FolderFillingStats& stats) const
+    {
+        stats.dpMemoryBytes = std::max(stats.dpMemoryBytes, memoryBytes());
+        stats.cells += (long long)(recomputedRows + items) * (capacity + 1); // rows are rebuilt to backtrack
+        stats.reusedCells += (long long)reusedRows * (capacity + 1);
+        stats.recomputedCells += (long long)recomputedRows * (capacity + 1);
+    }
+};
+
+// Subset-sum over the reachable sums only: a sorted list of the distinct sums of the items added so far,
+// each sum a state that remembers the item that reached it and the state it came from (for backtracking).
+// the cost follows the number of distinct sums, not the resolution of the durations, so it does not
+// change when the durations go from seconds to milliseconds.
+// a sum that can not beat the best one even with every item left is dropped (dominance pruning),
+// and the search stops once a sum fills the whole capacity. items are added in order and a sum keeps
+// the state that reached it first, so among the items of positive duration it picks the ones the table picks.
+// unlike the table it also takes every zero duration item along (fillFolders hands it none).
+// sums stay ints: a kept sum never goes over the capacity, an int, and a sum plus an item is compared
+// in long long before it is kept. only the totals of the items left (suffix) need long long.
+// the states never go over maxStates: past that, few items (<= meetInTheMiddleItems) are solved exactly
+// by meet in the middle (2^20 sums per half at most), otherwise the folder is solved again with sums closer than epsilon*C/n merged
+// (the folder is then within epsilon*C of the best one), epsilon doubling until it fits, and a budget
+// too small for epsilon = 1 only gets a first-fit folder
+template <class Allocator = std::allocator<int>>
+struct SparseSubsetSum {
+    using allocator_type = Allocator;
+    struct State {
+        int sum;
+        int item;       // item that reached this sum, -1 for the empty set
+        int previous;   // state it was reached from
+    };
+    using Indexes = std::vector<int, Rebind<Allocator, int>>;
+    using Sums = std::vector<long long, Rebind<Allocator, long long>>;
+    static constexpr int meetInTheMiddleItems = 40;
+    static constexpr size_t defaultMaxStates = 1 << 22;
+    static constexpr double defaultEpsilon = 0.0001;
+
+    int capacity;
+    size_t maxStates;
+    double epsilon;
+    Allocator allocator;
+    std::vector<State, Rebind<Allocator, State>> states;
+    Indexes current, next;                      // state ids by increasing sum
+    Indexes chosen;                             // items of the last solve(), decreasing
+    long long statesCreated = 0;                // by the last solve()
+    size_t peakBytes = 0;
+    double lastEpsilon = 0;                     // epsilon the last solve() needed, 0 when exact
+    bool lastMeetInTheMiddle = false;
+
+    explicit SparseSubsetSum(int capacity, size_t maxStates = defaultMaxStates, double epsilon = defaultEpsilon,
+        const Allocator& allocator = Allocator())
+        : capacity(capacity), maxStates(maxStates), epsilon(epsilon), allocator(allocator), states(Rebind<Allocator, State>(allocator)),
+        current(Rebind<Allocator, int>(allocator)), next(Rebind<Allocator, int>(allocator)), chosen(Rebind<Allocator, int>(allocator))
+    {
+    }
+
+    allocator_type get_allocator() const { return allocator; }
+    std::string name() const { return "sparse (" + std::to_string(maxStates) + " states)"; }
+
+    // drops the states that no listed sum leads back to (pruned and merged sums, and their own ancestors),
+    // returns false when that does not free a quarter of them
+    //TIME COMPLEXITY: O(states log states)
+    bool compact()
+    {
+        Rebind<Allocator, int> indexAllocator(allocator);
+        Indexes newId(states.size(), -1, indexAllocator), live(indexAllocator);
+        auto mark = [&](int state) {
+            for (; state >= 0 && newId[state] < 0; state = states[state].previous) {
+                newId[state] = 0;
+                live.push_back(state);
+            }
+        };
+        for (int state : current) mark(state);
+        for (int state : next) mark(state);
+
+        std::sort(live.begin(), live.end()); // a state comes after the one it was reached from, it still does
+        for (size_t i = 0; i < live.size(); i++) newId[live[i]] = (int)i;
+        for (size_t i = 0; i < live.size(); i++) {
+            State state = states[live[i]];
+            if (state.previous >= 0) state.previous = newId[state.previous];
+            states[i] = state;
+        }
+        states.resize(live.size());
+        for (int& state : current) state = newId[state];
+        for (int& state : next) state = newId[state];
+        return states.size() < maxStates / 4 * 3;
+    }
+
+    // one pass over the items in order, sums closer than granularity to a kept smaller one are dropped.
+    // returns false when the states would go over maxStates
+    //TIME COMPLEXITY: O(n * distinct sums)
+    template <class Durations>
+    bool run(const Durations& durations, const Indexes& order, const Sums& suffix, long long granularity)
+    {
+        states.assign(1, { 0, -1, -1 });
+        current.assign(1, 0);
+        for (size_t k = 0; k < order.size() && states[current.back()].sum < capacity; k++) { //θ(n)
+            int duration = durations[order[k]];
+            next.clear();
+            size_t shifted = 0;
+            long long lastKept = -granularity - 1;
+            auto keep = [&](int sum, int stateId) {
+                if (sum <= lastKept + granularity) return true; // same sum, or merged into the one below
+                if (stateId < 0) {
+                    if (states.size() >= maxStates && !compact()) return false;
+                    states.push_back({ sum, order[k], current[shifted - 1] });
+                    stateId = (int)states.size() - 1;
+                }
+                next.push_back(stateId);
+                lastKept = sum;
+                return true;
+            };
+
+            // merge the sums without this item and the ones with it, both sorted
+            for (size_t i = 0; i < current.size(); i++) { //θ(distinct sums)
+                int sum = states[current[i]].sum;
+                while (shifted < current.size() && (long long)states[current[shifted]].sum + duration < sum) {
+                    int shiftedSum = states[current[shifted++]].sum + duration;
+                    if (!keep(shiftedSum, -1)) return false;
+                }
+                if (!keep(sum, current[i])) return false;
+            }
+            while (shifted < current.size() && (long long)states[current[shifted]].sum + duration <= capacity) {
+                int shiftedSum = states[current[shifted++]].sum + duration;
+                if (!keep(shiftedSum, -1)) return false;
+            }
+
+            // dominance: a sum that can not beat the best one with every item left is dropped,
+            // those are a prefix of the list
+            long long best = states[next.back()].sum;
+            size_t firstUseful = 0;
+            while (firstUseful + 1 < next.size() && states[next[firstUseful]].sum + suffix[k + 1] <= best) firstUseful++;
+            current.assign(next.begin() + firstUseful, next.end());
+            statesCreated += next.size();
+        }
+
+        for (int state = current.back(); states[state].item >= 0; state = states[state].previous) {
+            chosen.push_back(states[state].item);
+        }
+        peakBytes = std::max(peakBytes, states.capacity() * sizeof(State) + (current.capacity() + next.capacity()) * sizeof(int));
+        return true;
+    }
+
+    // exact, every subset of each half: the best sum of one half that fits next to each sum of the other
+    //TIME COMPLEXITY: O(2^(n/2) * n)
+    template <class Durations>
+    void meetInTheMiddle(const Durations& durations, const Indexes& order)
+    {
+        using Sum = std::pair<long long, uint32_t>;     // sum, items of the half as bits
+        int half = (int)order.size() / 2;
+        auto subsetSums = [&](int from, int to) {
+            std::vector<Sum, Rebind<Allocator, Sum>> sums(size_t(1) << (to - from), Sum(), Rebind<Allocator, Sum>(allocator));
+            for (uint32_t mask = 1; mask < sums.size(); mask++) {
+                int bit = lowestBit(mask);
+                sums[mask] = { sums[mask & (mask - 1)].first + durations[order[from + bit]], mask };
+            }
+            statesCreated += sums.size();
+            return sums;
+        };
+        auto low = subsetSums(0, half), high = subsetSums(half, (int)order.size());
+        std::sort(high.begin(), high.end()); //O(2^(n/2) n)
+        peakBytes = std::max(peakBytes, (low.size() + high.size()) * sizeof(Sum));
+
+        long long best = -1;
+        uint32_t bestLow = 0, bestHigh = 0;
+        for (const auto& [sum, mask] : low) {
+            if (sum > capacity) continue;
+            auto fit = std::upper_bound(high.begin(), high.end(), Sum(capacity - sum, UINT32_MAX)); // high[0] sums to 0
+            if (sum + std::prev(fit)->first > best) {
+                best = sum + std::prev(fit)->first;
+                bestLow = mask;
+                bestHigh = std::prev(fit)->second;
+            }
+        }
+        for (int i = 0; i < half; i++)
+            if (bestLow >> i & 1) chosen.push_back(order[i]);
+        for (int i = half; i < (int)order.size(); i++)
+            if (bestHigh >> (i - half) & 1) chosen.push_back(order[i]);
+    }
+
+    // the items of one folder with the max duration that fits, items of zero duration go along with it.
+    // there is nothing to reuse from the last folder
+    template <class Durations>
+    int solve(const Durations& durations, int)
+    {
+        Rebind<Allocator, int> indexAllocator(allocator);
+        Indexes order(indexAllocator);
+        chosen.clear();
+        for (int i = 0; i < (int)durations.size(); i++) { //θ(n)
+            if (durations[i] == 0)
+                chosen.push_back(i);
+            else if (durations[i] <= capacity)
+                order.push_back(i);
+        }
+        Sums suffix(order.size() + 1, 0, Rebind<Allocator, long long>(allocator)); // suffix[k] = sum of the items order[k..]
+        for (int k = (int)order.size() - 1; k >= 0; k--) suffix[k] = suffix[k + 1] + durations[order[k]];
+
+        statesCreated = 0;
+        lastEpsilon = 0;
+        lastMeetInTheMiddle = false;
+        size_t chosenZeros = chosen.size();
+        if (!run(durations, order, suffix, 0)) {
+            chosen.resize(chosenZeros);
+            if (order.size() <= meetInTheMiddleItems) {
+                lastMeetInTheMiddle = true;
+                meetInTheMiddle(durations, order);
+            }
+            else {
+                // merging sums granularity apart loses at most granularity per item
+                bool solved = false;
+                for (lastEpsilon = epsilon; lastEpsilon < 2 && !solved; lastEpsilon *= 2) {
+                    long long granularity = std::max(1LL, (long long)(lastEpsilon * capacity / order.size()));
+                    chosen.resize(chosenZeros);
+                    solved = run(durations, order, suffix, granularity);
+                }
+                lastEpsilon = std::min(lastEpsilon / 2, 1.0);
+                if (!solved) {
+                    // a budget too small for even that: the items in order while they fit
+                    chosen.resize(chosenZeros);
+                    long long sum = 0;
+                    for (int item : order) {
+                        if (sum + durations[item] > capacity) continue;
+                        sum += durations[item];
+                        chosen.push_back(item);
+                    }
+                }
+            }
+        }
+        // a folder of many items must not keep its peak for the next ones
+        Rebind<Allocator, State> stateAllocator(allocator);
+        std::vector<State, Rebind<Allocator, State>>(stateAllocator).swap(states);
+        std::sort(chosen.rbegin(), chosen.rend());
+
+        int total = 0;
+        for (int item : chosen) total += durations[item];
+        return total;
+    }
+
+    template <class Durations, class Chosen>
+    void backtrack(const Durations&, Chosen& chosenItems) const
+    {
+        chosenItems.insert(chosenItems.end(), chosen.begin(), chosen.end());
+    }
+
+    void record(FolderFillingStats& stats) const
+    {
+        stats.dpMemoryBytes = std::max(stats.dpMemoryBytes, peakBytes);
+        stats.cells += statesCreated;
+        stats.recomputedCells += statesCreated;
+        stats.meetInTheMiddleFolders += lastMeetInTheMiddle;
+        stats.approximateFolders += (lastEpsilon > 0);
+        stats.maxEpsilon = std::max(stats.maxEpsilon, lastEpsilon);
+    }
+};
+
+namespace detail {
+struct NoFolderCallback {
+    void operator()(size_t) const {}
+};
+}
+
+// folder filling with a subset-sum engine: every folder is appended to folders as indexes into durations
+// (converted to Key), then onFolder gets its index so it can be used while the next one is packed.
+// like fillFoldersByDuration, an item longer than the capacity gets a folder of its own first (longest first)
+// and the zero duration items go along with the first folder, the engine only sees the others.
+// when stop is set it gives up before its next folder (stats.aborted)
+//TIME COMPLEXITY: O(n) subset sums of the engine, O(n^2 * C) with the table
+template <class Engine, class Key, class Allocator, class OnFolder = detail::NoFolderCallback>
+FolderFillingStats fillFolders(Engine& engine, const int* durations, size_t count, FolderTable<Key, Allocator>& folders,
+    OnFolder onFolder = OnFolder(), const std::atomic<bool>* stop = nullptr)
+{
+    using Clock = std::chrono::steady_clock;
+    using Work = Rebind<typename Engine::allocator_type, int>;
+    FolderFillingStats stats;
+    stats.engineName = engine.name();
+    folders.reserve(0, count);
+
+    // the engine chooses among the items left, itemIndexes maps them back to their index in durations
+    Work work(engine.get_allocator());
+    std::vector<int, Work> left(work), itemIndexes(work), chosen(work), zeroDurationItems(work), oversizedItems(work);
+    left.reserve(count);
+    itemIndexes.reserve(count);
+    for (size_t i = 0; i < count; i++) { //θ(n)
+        if (durations[i] == 0)
+            zeroDurationItems.push_back((int)i);    // fits anywhere, the table would never pick it
+        else if (durations[i] > engine.capacity)
+            oversizedItems.push_back((int)i);       // fits nowhere, the engine would pick nothing
+        else {
+            left.push_back(durations[i]);
+            itemIndexes.push_back((int)i);
+        }
+    }
+
+    std::stable_sort(oversizedItems.begin(), oversizedItems.end(),
+        [durations](int a, int b) { return durations[a] > durations[b]; }); //O(k log k)
+    for (int item : oversizedItems) {
+        folders.push_back((Key)item);
+        folders.closeFolder();
+        onFolder(folders.size() - 1);
+    }
+    for (int item : zeroDurationItems) folders.push_back((Key)item);
+
+    // after a folder is removed, every row up to the first removed item is still valid
+    int reusable = 0;
+
+    // worst case: every item gets a folder of its own, n subset sums
+    while (!left.empty()) {
+        if (stop && *stop) {
+            stats.aborted = true;
+            break;
+        }
+
+        int items = (int)left.size();
+        chosen.clear();
+        auto start = Clock::now();
+        engine.solve(left, reusable);
+        auto backtrackStart = Clock::now();
+        engine.backtrack(left, chosen);
+        auto end = Clock::now();
+        stats.packNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+        stats.backtrackNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(end - backtrackStart).count();
+        stats.folderSolves++;
+        engine.record(stats);
+        if (chosen.empty())
+            throw std::logic_error("fillFolders: the subset-sum engine chose no item, the folders would never end");
+
+        // indexes are chosen from the last item down, so the last one is the first item to be removed
+        reusable = chosen.empty() ? items + 1 : chosen.back() + 1;
+
+        // hand the folder over then remove its items to fill the next one
+        for (int item : chosen) folders.push_back((Key)itemIndexes[item]); //O(n)
+        folders.closeFolder();
+        onFolder(folders.size() - 1);
+        // chosen indexes are decreasing, the next one to skip is at its end
+        size_t kept = 0, skip = chosen.size();
+        for (size_t i = 0; i < left.size(); i++) { //θ(n)
+            if (skip > 0 && (int)i == chosen[skip - 1]) {
+                skip--;
+                continue;
+            }
+            left[kept] = left[i];
+            itemIndexes[kept++] = itemIndexes[i];
+        }
+        left.resize(kept);
+        itemIndexes.resize(kept);
+    }
+    if (folders.pending() > 0 && !stats.aborted) {
+        folders.closeFolder(); // only zero duration items, the engine had nothing to pack
+        onFolder(folders.size() - 1);
+    }
+    return stats;
+}
+
+template <class Engine, class DurationAllocator, class Key, class Allocator, class OnFolder = detail::NoFolderCallback>
+FolderFillingStats fillFolders(Engine& engine, const std::vector<int, DurationAllocator>& durations, FolderTable<Key, Allocator>& folders,
+    OnFolder onFolder = OnFolder(), const std::atomic<bool>* stop = nullptr)
+{
+    return fillFolders(engine, durations.data(), durations.size(), folders, onFolder, stop);
+}
+
+
+//########################### FOLDER FILLING WITH DURATION CLASSES ###################################
+
+namespace detail {
+
+// all items of the same duration are interchangeable for the subset sum,
+// so they are grouped into one class and the DP works per class instead of per item
+template <class Allocator>
+struct DurationClass {
+    int duration;
+    std::vector<int, Rebind<Allocator, int>> items;     // items of this duration, in their order
+    size_t taken = 0;                                   // items[0..taken) are already in a folder
+
+    int count() const { return (int)(items.size() - taken); }
+};
+
+// bounded subset-sum over the classes: used[k][j] is the fewest items of class k needed to reach
+// sum j on top of a sum reachable with classes 0..k-1, or -1 if j is not reachable.
+// the count only ever grows along j, j-d, j-2d... so one pass per class is enough whatever its count
+// returns the max duration that fits in one folder
+//TIME COMPLEXITY: θ(k*C) where k is the number of classes
+template <class Classes, class Used, class Allocator>
+int boundedSubsetSum(int capacity, const Classes& classes, Used& used, const Allocator& allocator)
+{
+    std::vector<char, Rebind<Allocator, char>> reachable((size_t)capacity + 1, 0, Rebind<Allocator, char>(allocator)); //θ(C)
+    reachable[0] = 1;
+
+    for (size_t k = 0; k < classes.size(); k++) { //θ(k)
+        int duration = classes[k].duration;
+        int count = classes[k].count();
+        auto& classUsed = used[k];
+
+        for (int j = 0; j <= capacity; j++) { //θ(C)
+            if (reachable[j])
+                classUsed[j] = 0; // reachable without this class
+            else if (j >= duration && classUsed[j - duration] >= 0 && classUsed[j - duration] < count)
+                classUsed[j] = classUsed[j - duration] + 1; // one more item of this class
+            else
+                classUsed[j] = -1;
+        }
+        for (int j = 0; j <= capacity; j++) { //θ(C)
+            reachable[j] = (classUsed[j] >= 0);
+        }
+    }
+
+    int maxDuration = capacity;
+    while (!reachable[maxDuration]) maxDuration--; //O(C), 0 is always reachable
+    return maxDuration;
+}
+
+}
+
+// Folder filling over duration classes, every folder takes the max duration that fits like fillFolders,
+// but the work per folder scales with the number of distinct durations instead of the number of items.
+// an item longer than the capacity gets a folder of its own first, longest first, like First-Fit Decreasing,
+// and the items of zero duration go along with the first folder of the DP.
+// when stop is set it gives up before its next folder (stats.aborted)
+//TIME COMPLEXITY: O(n log n + f * k * C) where f is the number of folders and k the number of distinct durations
+template <class Key, class Allocator, class WorkAllocator = std::allocator<int>>
+FolderFillingStats fillFoldersByDuration(int capacity, const int* durations, size_t count, FolderTable<Key, Allocator>& folders,
+    const std::atomic<bool>* stop = nullptr, const WorkAllocator& allocator = WorkAllocator())
+{
+    using Indexes = std::vector<int, Rebind<WorkAllocator, int>>;
+    using Class = detail::DurationClass<WorkAllocator>;
+    using Used = std::vector<int, Rebind<WorkAllocator, int>>;
+    FolderFillingStats stats;
+    stats.engineName = "duration classes";
+
+    // group the items by duration, classes end up in increasing duration
+    Rebind<WorkAllocator, int> indexAllocator(allocator);
+    Indexes order(count, 0, indexAllocator);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return durations[a] < durations[b]; }); //O(n log n)
+
+    Rebind<WorkAllocator, Class> classAllocator(allocator);
+    std::vector<Class, Rebind<WorkAllocator, Class>> classes(classAllocator);
+    Indexes zeroDurationItems(indexAllocator), oversizedItems(indexAllocator);
+    for (int item : order) { //θ(n)
+        int duration = durations[item];
+        if (duration == 0)
+            zeroDurationItems.push_back(item);  // fits anywhere, no need for the DP
+        else if (duration > capacity)
+            oversizedItems.push_back(item);     // fits nowhere, not a class of the DP
+        else {
+            if (classes.empty() || classes.back().duration != duration)
+                classes.push_back({ duration, Indexes(indexAllocator) });
+            classes.back().items.push_back(item);
+        }
+    }
+    stats.durationClasses = (int)classes.size();
+
+    std::vector<Used, Rebind<WorkAllocator, Used>> used(classes.size(), Used((size_t)capacity + 1, -1, indexAllocator),
+        Rebind<WorkAllocator, Used>(allocator));
+    stats.dpMemoryBytes = used.size() * ((size_t)capacity + 1) * sizeof(int);
+
+    // items go straight into the table, the first folder of the DP takes the zero duration items along
+    folders.reserve(0, count);
+    for (auto item = oversizedItems.rbegin(); item != oversizedItems.rend(); ++item) { //θ(items longer than the capacity)
+        folders.push_back((Key)*item);
+        folders.closeFolder();
+    }
+    for (int item : zeroDurationItems) folders.push_back((Key)item);
+
+    while (!classes.empty()) {
+        if (stop && *stop) {
+            stats.aborted = true;
+            return stats;
+        }
+
+        int remaining = detail::boundedSubsetSum(capacity, classes, used, allocator); //θ(k * C)
+        stats.cells += (long long)classes.size() * (capacity + 1);
+        stats.folderSolves++;
+
+        // backtracking: class k gave used[k][sum] items, the rest comes from classes before it
+        for (int k = (int)classes.size() - 1; k >= 0; --k) { //θ(k + items in the folder)
+            int taken = used[k][remaining];
+            for (int t = 0; t < taken; t++) {
+                folders.push_back((Key)classes[k].items[classes[k].taken++]);
+            }
+            remaining -= taken * classes[k].duration;
+        }
+        folders.closeFolder(); // not empty, an item of every class fits on its own
+
+        // drop the classes that ran out of items
+        classes.erase(std::remove_if(classes.begin(), classes.end(),
+            [](const Class& c) { return c.count() == 0; }), classes.end());
+    }
+    if (folders.pending() > 0)
+        folders.closeFolder(); // only zero duration items, no class was left for them
+    return stats;
+}
+
+template <class DurationAllocator, class Key, class Allocator, class WorkAllocator = std::allocator<int>>
+FolderFillingStats fillFoldersByDuration(int capacity, const std::vector<int, DurationAllocator>& durations, FolderTable<Key, Allocator>& folders,
+    const std::atomic<bool>* stop = nullptr, const WorkAllocator& allocator = WorkAllocator())
+{
+    return fillFoldersByDuration(capacity, durations.data(), durations.size(), folders, stop, allocator);
+}
+
+}
@@ -1,581 +1,3838 @@
-﻿#include <iostream>
-#include <vector>
-#include <string>
-#include <sstream>
-#include <algorithm>
-#include <fstream>
-#include <filesystem>
-#include<queue>
-
-using namespace std;
-namespace fs = filesystem;
-
-
-//########################### HELPER FUNCTIONS ###################################
-
-// Folder structure to represent each folder
-struct Folder {
-    vector<pair<string, int>> files;        // Files in this folder
-    int remainingCapacity = 0;                  // Remaining capacity of the folder
-};
-
-// Comparator for priority queue (max-heap)
-// Ensures the folder with the most remaining capacity is at the top
-struct Compare {
-    bool operator()(const Folder& f1, const Folder& f2) {
-        return f1.remainingCapacity < f2.remainingCapacity; // Max-heap
-    }
-};
-
-// convert HH:MM:SS to seconds
-int timeToSeconds(const string& time) 
-{
-    int hours, minutes, seconds;
-    sscanf_s(time.c_str(), "%d:%d:%d", &hours, &minutes, &seconds);
-    return hours * 3600 + minutes * 60 + seconds;
-}
-
-//converts seconds to time format (HH:MM:SS) for filling metadata file
-string secondsToTime(int totalSeconds) 
-{
-    int hours = totalSeconds / 3600;
-    int minutes = (totalSeconds % 3600) / 60;
-    int seconds = totalSeconds % 60;
-
-    string result =
-        (hours < 10 ? "0" : "") + to_string(hours) + ":" +
-        (minutes < 10 ? "0" : "") + to_string(minutes) + ":" +
-        (seconds < 10 ? "0" : "") + to_string(seconds);
-
-    return result;
-}
-
-// Sort files in descending order
-bool compareFiles(const pair<string, int>& a, const pair<string, int>& b) {
-    return a.second > b.second;
-}
-void sortFiles(vector<pair<string, int>>& files) {
-    sort(files.begin(), files.end(), compareFiles);
-}
-
-
-//function that copies BATCH OF FILES into a destination folder.
-//this function will not work properly with processing files one by one each call.
-//folderName represents the algorithm you are working on. 
-//e.g: [3] FirstFit Decreasing. CHECK SAMPLE TESTS
-void processFiles(vector<pair<string, int>>& files, int folderCount, vector<int>& chosenFilesIndexes, string folderName, string testNo, bool removeFiles) {
-    
-    string directory = "../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName + "/F" + to_string(folderCount);
-
-    if (!fs::exists(directory))
-    {
-        fs::create_directory(directory);
-
-    }
-
-    //cout << "Folder " << folderCount << ":\n";
-    ofstream metadataFile(directory + "_metadata.txt");
-
-    int currentFolderDuration = 0;
-
-    for (int fileIndex : chosenFilesIndexes) 
-    {
-        string fileName = files[fileIndex].first;
-        int fileDuration = files[fileIndex].second;
-
-        string sourcePath = "../Sample Tests/Sample " + testNo + "/INPUT/Audios/" + fileName;
-        string destinationPath = directory + "/" + fileName;
-
-        fs::copy(sourcePath, destinationPath, fs::copy_options::overwrite_existing);
-
-        //print on console and add file to metadata.txt
-          //cout << fileName << " " << secondsToTime(fileDuration) << "\n";
-          metadataFile << fileName << " " << secondsToTime(fileDuration) << "\n";
-
-          
-          currentFolderDuration += fileDuration;
-          // Remove file from the list if removeFiles is true
-          if (removeFiles) {
-              files.erase(files.begin() + fileIndex);
-          }
-    }
-
-    //cout << secondsToTime(currentFolderDuration) << "\n\n";
-    metadataFile << secondsToTime(currentFolderDuration) << "\n";
-    metadataFile.close();
-}
-
-void displayProgressBar(int current, int total) {
-    const int barWidth = 50; // Width of the progress bar
-    float progress = (float)current / total;
-
-    cout << "[";
-    int pos = barWidth * progress;
-    for (int i = 0; i < barWidth; ++i) {
-        if (i < pos) cout << "=";
-        else if (i == pos) cout << ">";
-        else cout << " ";
-    }
-    cout << "] " << int(progress * 100.0) << " %\r";
-    cout.flush();
-}
-
-//########################### WORST FIT (DECREASING) LINEAR ALGORITHM ###################################
-
-// Worst-Fit Linear algorithm - handles file placement and folder filling
-// TIME COMPLEXITY O(n*m) where n is the number of files and m is the number of folders
-vector<Folder> worstFitLinear(int folderCapacity, vector<pair<string, int>>& files) { // O(n*m)
-	vector<Folder> folders; //O(1)
-
-    // Iterate through each file
-	for (const auto& file : files) { //O(n)
-		string fileName = file.first; //O(1)
-		int fileDuration = file.second; //O(1)
-
-        // Find the folder with the most remaining capacity (linear search)
-		int maxCapacityIndex = -1; //O(1)
-		int maxCapacity = -1; //O(1)
-		for (int i = 0; i < folders.size(); ++i) { //O(m)
-			if (folders[i].remainingCapacity >= fileDuration && folders[i].remainingCapacity > maxCapacity) { //O(1)
-				maxCapacity = folders[i].remainingCapacity; //O(1)
-				maxCapacityIndex = i; //O(1)
-            }
-        }
-
-        // Place file in the folder with the most capacity or create a new folder
-		if (maxCapacityIndex != -1) { //O(1)
-			folders[maxCapacityIndex].files.emplace_back(fileName, fileDuration); //O(1)
-			folders[maxCapacityIndex].remainingCapacity -= fileDuration; //O(1)
-        }
-		else { //O(1)
-			Folder newFolder; //O(1)
-			newFolder.files.emplace_back(fileName, fileDuration); //O(1)
-			newFolder.remainingCapacity = folderCapacity - fileDuration; //O(1)
-			folders.push_back(newFolder);   //O(1)
-        }
-    }
-
-	return folders; //O(1)
-}
-
-// Worst-Fit Decreasing Linear caller function - handles the setup and processing of folders
-// TIME COMPLEXITY O(max(nlogn, n*m)) where n is the number of files and m is the number of folders
-void WFDLinearCaller(int folderCapacity, vector<pair<string, int>> files, string testNo) { //O(max(nlogn, n*m))
-	string folderName = "[2.1] WorstFit Decreasing Linear"; //O(1)
-	filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); //O(1)
-
-    // Sort files in descending order
-	sortFiles(files); //O(nlogn)
-
-    // Apply Worst-Fit Decreasing Linear algorithm
-	vector<Folder> folders = worstFitLinear(folderCapacity, files); //O(n*m)
-
-    // Process and save folders
-	int folderCount = 1; //O(1)
-	for (size_t i = 0; i < folders.size(); ++i) { //O(m)
-		vector<int> chosenFilesIndexes; //O(1)
-		for (size_t j = 0; j < folders[i].files.size(); ++j) { //O(n)
-			chosenFilesIndexes.push_back(j); //O(1) Push indexes relative to the current folder
-        }
-
-        // Process files and save metadata
-		processFiles(folders[i].files, folderCount++, chosenFilesIndexes, folderName, testNo, false); //O(1)
-        displayProgressBar(i + 1, folders.size()); // Update progress bar
-    }
-	cout << "\nFolder Count: " << folderCount - 1 << endl;
-}
-
-//the caller function for Worst-Fit Linear algorithm
-// TIME COMPLEXITY O(n*m) where n is the number of files and m is the number of folders
-void worstFitLinearCaller(int folderCapacity, vector<pair<string, int>> files, string testNo) { //O(n*m)
-	string folderName = "[1.1] WorstFit Linear"; //O(1)
-	filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); //O(1)
-
-
-    // Apply Worst-Fit Decreasing Linear algorithm
-	vector<Folder> folders = worstFitLinear(folderCapacity, files); //O(n*m)
-
-    // Process and save folders
-	int folderCount = 1; //O(1)
-	for (size_t i = 0; i < folders.size(); ++i) { //O(m)
-		vector<int> chosenFilesIndexes; //O(1)
-		for (size_t j = 0; j < folders[i].files.size(); ++j) { //O(n)
-			chosenFilesIndexes.push_back(j); //O(1) Push indexes relative to the current folder
-        }
-        // Process files and save metadata
-		processFiles(folders[i].files, folderCount++, chosenFilesIndexes, folderName, testNo, false); //O(1)
-        displayProgressBar(i + 1, folders.size()); // Update progress bar
-    }
-    cout << "\nFolder Count: " << folderCount - 1 << endl; //O(1)
-}
-
-
-
-//########################### WORST FIT (DECREASING) PQ ALGORITHM ###################################
-
-// Worst-Fit  Algorithm using PRIORITY QUEUE, main logic is here.
-// Function to distribute files into folders using the Worst-Fit algorithm
-// TIME COMPLEXITY: O(n log m) where n is the number of files and m is the number of folders
-vector<Folder> worstFitPQ(vector<pair<string, int>> files, int capacity) // O(n log m)
-{
-    // Priority queue to manage folders, sorted by remaining capacity
-	priority_queue<Folder, vector<Folder>, Compare> folderPriorityQueue; // O(1)
-
-    // Loop through all the files
-    for (auto file : files) // O(n)
-    {
-        int duration = file.second; // O(1)
-
-        // Check if the largest folder in the queue can fit the file
-        if (!folderPriorityQueue.empty() && folderPriorityQueue.top().remainingCapacity >= duration)//O(log m)
-        {
-            // Update the top folder and re-insert into the queue
-            Folder topFolder = folderPriorityQueue.top(); // O(1)
-            folderPriorityQueue.pop(); // O(log m)
-            topFolder.files.push_back(file); // O(1)
-            topFolder.remainingCapacity -= duration; // O(1)
-            folderPriorityQueue.push(topFolder); // O(log m)
-        }
-        else
-        {
-            // Create a new folder and insert into the queue
-            Folder newFolder; // O(1)
-            newFolder.files.push_back(file); // O(1)
-            newFolder.remainingCapacity = capacity - duration; // O(1)
-            folderPriorityQueue.push(newFolder); // O(log m)
-        }
-    }
-
-    // Convert the priority queue into a vector of folders
-    vector<Folder> result; // O(1)
-    while (!folderPriorityQueue.empty()) // O(m)
-    {
-        result.push_back(folderPriorityQueue.top()); // O(1)
-        folderPriorityQueue.pop(); // O(log m)
-    }
-
-    return result; // O(1)
-}
-
-
- // Function to apply Worst-Fit Decreasing algorithm
-//TIME COMPLEXITY: O(n log n)
-void worstFitDecreasingPQCaller(int folderCapacity, vector<pair<string, int>> files, string testNo) // O(n log n)
-{
-    // Sort files in descending order based on size (preprocessing step for WFD)
-	sortFiles(files); // O(n log n)
-
-    // Create a directory for output
-	string folderName = "[2.0] WorstFit Decreasing PQ"; // O(1)
-	fs::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); // O(1)
-
-    // Apply the Worst-Fit algorithm
-	vector<Folder> folders = worstFitPQ(files, folderCapacity); // O(n log m)
-    int folderCount = 1; // O(1) To number folders sequentially
-    
-    // Process each folder to save its results
-    int j = 0;
-    for (auto folder : folders) // O(m)
-    {
-        
-        vector<int> chosenFilesIndexes; // O(1)
-
-        // Collect the indexes of files in this folder
-		for (int i = 0; i < folder.files.size(); i++) // O(n)
-		{
-			chosenFilesIndexes.push_back(i); // O(1)
-		}
-
-        // Copy the files to the folder and save metadata
-		processFiles(folder.files, folderCount, chosenFilesIndexes, folderName, testNo, false); // O(1)
-		folderCount++; // O(1)
-        displayProgressBar(j + 1, folders.size()); // Update progress bar
-        j++;
-    }
-    cout << "\nFolder Count: " << folderCount - 1 << endl; //O(1)  
-}
-
-/* Complexity Analysis:
- * - Sorting files: O(n log n).
- * - Applying the Worst-Fit algorithm: O(n log m)
- * Combined complexity: O(n log n), dominated by sorting.
- */
-
-
-
- // Function to apply the Worst-Fit algorithm
-void worstFitPQCaller(int folderCapacity, vector<pair<string, int>> files, string testNo) // O(n log m)
-{
-    // Create a directory for output
-	string folderName = "[1.0] WorstFit PQ"; // O(1)
-	fs::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); // O(1)
-
-    // Apply the Worst-Fit algorithm
-	vector<Folder> folders = worstFitPQ(files, folderCapacity); // O(n log m)
-    int folderCount = 1; // To number folders sequentially
-    int j = 0;
-    // Process each folder to save its results
-	for (auto folder : folders) // O(m)
-    {
-		vector<int> chosenFilesIndexes; // O(1)
-
-        // Collect the indexes of files in this folder
-		for (int i = 0; i < folder.files.size(); i++) // O(n)
-        {
-			chosenFilesIndexes.push_back(i); // O(1)
-        }
-
-        // Copy the files to the folder and save metadata
-		processFiles(folder.files, folderCount, chosenFilesIndexes, folderName, testNo, false); // O(1)
-		folderCount++; // O(1)
-        displayProgressBar(j + 1, folders.size()); // Update progress bar
-		j++;
-    }
-    cout << "\nFolder Count: " << folderCount - 1 << endl; //O(1)
-}
-
-/* Complexity Analysis:
- * - Applying the Worst-Fit algorithm: O(n log m)
- * Combined complexity: O(n log m).
- */
-
-
-//########################### FIRST FIT DECREASING ALGORITHM ###################################
-
-//Folder filling using First-Fit Decreasing (FFD) algorithm
-//TIME COMPLEXITY: O(n*m) where n is the number of files and m is the number of folders
-void folderFillingFFD(int folderCapacity, const vector<pair<string, int>>& files, vector<vector<int>>& folderFileIndexes) { //O(n*m)
-
-    // Vector to store remaining capacity of each folder
-	vector<int> folderCapacities; //O(1)
-
-    // Iterate over each file
-	for (int fileIndex = 0; fileIndex < files.size(); ++fileIndex) { //O(n)
-		const auto& file = files[fileIndex]; //O(1)
-		bool placed = false; //O(1)
-
-        // Try to place the file in the first folder with enough capacity
-		for (int folderIndex = 0; folderIndex < folderCapacities.size(); ++folderIndex) { //O(m)
-			if (file.second <= folderCapacities[folderIndex]) { //O(1)
-                folderCapacities[folderIndex] -= file.second; //O(1)
-                folderFileIndexes[folderIndex].push_back(fileIndex); //O(1)
-				placed = true; //O(1)
-				break; //O(1)
-            }
-        }
-
-        // If the file couldn't be placed, create a new folder
-		if (!placed) { //O(1)
-			folderCapacities.push_back(folderCapacity - file.second); //O(1)
-			folderFileIndexes.emplace_back(vector<int>{fileIndex}); //O(1)
-        }
-    }
-}
-
-//First-Fit Decreasing (FFD) caller
-//TIME COMPLEXITY: O(max(nlogn, n*m)) where n is the number of files and m is the number of folders
-void FirstFitDecreasing(int folderCapacity, vector<pair<string, int>> files, string testNo) { //O(n*m)
-	string folderName = "[3] FirstFit Decreasing"; //O(1)
-	filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); //O(1)
-    //Sort files in descending order
-    sortFiles(files); //O(nlogn)
-
-    //Assign files to folders using FFD algorithm
-	vector<vector<int>> folderFileIndexes; //O(1)
-	folderFillingFFD(folderCapacity, files, folderFileIndexes); //O(n*m)
-
-    //Process each folder
-	int folderIndex; //O(1)
-	for (folderIndex = 0; folderIndex < folderFileIndexes.size(); ++folderIndex) { //O(m)
-		const auto& fileIndexes = folderFileIndexes[folderIndex]; //O(1)
-		processFiles(files, folderIndex + 1, const_cast<vector<int>&>(fileIndexes), folderName, testNo, false); //O(1)
-        displayProgressBar(folderIndex + 1, folderFileIndexes.size()); // Update progress bar
-    }
-    cout << "\nFolder Count: " << folderIndex << endl; //O(1)
-}
-
-
-
-//########################### FOLDER FILLING DP ALGORITHM ###################################
-
-// folder filling algorithm using dynamic programming bottom up approach
-//TIME COMPLEXITY: θ(n*m)
-int folderFillingAlgorithm(int capacity, int numOfFiles, vector<pair<string, int>>& files, vector<vector<int>>& dpMemory)
-{
-
-    // filling the DP table
-    for (int i = 0; i <= numOfFiles; i++) //θ(n*m) where n is number of files, m is the desired capacity
-    {
-        for (int j = 0; j <= capacity; j++) //θ(m) where m is the desired capacity
-        {
-            if (i == 0 || j == 0) //no files left or no capacity //θ(1)
-            {
-                dpMemory[i][j] = 0;  //θ(1)
-            }
-            else if (files[i - 1].second <= j)  // if the current file fits  //θ(1)
-            {
-                // get max of including or excluding the file
-                dpMemory[i][j] = max(dpMemory[i - 1][j],
-                    dpMemory[i - 1][j - files[i - 1].second] + files[i - 1].second);  //θ(1)
-            }
-            else
-            {
-                // If the file doesnt fit, exclude it
-                dpMemory[i][j] = dpMemory[i - 1][j];   //θ(1)
-            }
-        }
-    }
-
-    //max capacity of folder (no combination of files yet)
-    return dpMemory[numOfFiles][capacity];  //θ(1)
-}
-
-
-// Folder filling caller
-// TIME COMPLEXITY: FOLDER PROCESSING + O(n^2 * m) where n is number of files and m is desired capacity
-void folderFilling(int folderCapacity, vector<pair<string, int>> files, string testNo)
-{
-    string folderName = "[4] FolderFilling";  //θ(1)
-    filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName);
-
-    int folderCount = 1;   //θ(1)
-
-    int totalFiles = files.size(); // Total number of files
-    int processedFiles = 0; // Count of files processed
-
-    //2D Dynamic Array for saving DP results
-    vector<vector<int>> dpMemory(files.size() + 1, vector<int>(folderCapacity + 1, 0));  //θ(1)
-
-    long long totalTime = 0;
-
-    //worst case scenario: each file is put on a folder by itself, running the folderFillingAlgorithm n times.
-    while (!files.empty()) // O(n*n*m) = O(n^2 * m) where n is number of files and m is desired capacity
-    {
-
-        int numberOfFiles = files.size();  //θ(1)
-
-        auto startTime = chrono::high_resolution_clock::now();
-
-        // get max duration for the current folder
-        int maxDuration = folderFillingAlgorithm(folderCapacity, numberOfFiles, files, dpMemory); //θ(n * m)
-
-
-
-        // backtracking phase
-        vector<int> chosenFilesIndexes;
-        int remainingCapacity = folderCapacity;  //θ(1)
-        for (int i = numberOfFiles; i > 0; --i) //θ(n) where n is number of files
-        {
-            //if previous row has different value, means we took the file to maximize capacity
-            if (dpMemory[i][remainingCapacity] != dpMemory[i - 1][remainingCapacity])  //θ(1)
-            {
-                chosenFilesIndexes.push_back(i - 1); // file index is 0 based  //O(1)
-                remainingCapacity -= files[i - 1].second;    //θ(1)
-                processedFiles++; // Increment the count of processed files
-
-            }
-            
-        }
-
-        auto endTime = chrono::high_resolution_clock::now();
-        auto duration = chrono::duration_cast<chrono::nanoseconds>(endTime - startTime);
-        totalTime += duration.count();
-
-        //copy chosen files to the current folder and remove them to continue filling other folders
-		processFiles(files, folderCount, chosenFilesIndexes, folderName, testNo, true);
-        int progress = (processedFiles * 100) / totalFiles;  // Calculate progress
-        displayProgressBar(progress, 100);         folderCount++; //θ(1)
-    }
-    cout << "\nFolder Count: " << folderCount - 1 << endl; //O(1)
-
-    cout << "Total execution time of folderFillingAlgorithm across all iterations: "
-        << totalTime << " nanoseconds" << endl;
-    cout << "Total execution time in milliseconds: "
-        << totalTime / 1e6 << " ms" << endl;
-    cout << "Total execution time in seconds: "
-        << totalTime / 1e9 << " s" << endl;
-    cout << "\n-------------------------------------------------------------------------\n";
-}
-
-
-
-//########################### MAIN ###################################
-
-int main() 
-{
-
-    int x = 0;
-    while (x < 1 || x > 6 || (x == 0))
-    {
-        cout << "NOTE: Tests(1,2,3) are for small inputs, Tests(4,5,6) are for large inputs\n";
-        cout << "Enter test number (1,2,3,4,5,6): ";
-        cin >> x;
-    }
-
-    string testNo = to_string(x);
-    
-    //open and read metadata 
-    ifstream inputFile("../Sample Tests/Sample " + testNo + "/INPUT/AudiosInfo.txt");
-    if (!inputFile.is_open()) 
-    {
-        cerr << "Error: Could not open AudiosInfo.txt file." << endl;
-        return 1;
-    }
-
-    //if output file already exist, remove it to start on a fresh page
-    if (fs::exists("../Sample Tests/Sample " + testNo + "/OUTPUT"))
-    {
-        fs::remove_all("../Sample Tests/Sample " + testNo + "/OUTPUT");
-    }
-
-    int numberOfFiles;
-    inputFile >> numberOfFiles;
-
-    //reads file names and converts durations to seconds
-    vector<pair<string, int>> files(numberOfFiles);
-    for (int i = 0; i < numberOfFiles; ++i) 
-    {
-        string name, duration;
-        inputFile >> name >> duration;
-        files[i] = { name, timeToSeconds(duration) };
-    }
-
-
-    inputFile.close();
-
-    cout << "FOLDER CAPACITY CANT BE LESS THAN THE MAXIMUM AUDIO CAPACITY TO AVOID INFINITE LOOP\n";
-    cout << "Input folder capacity in seconds according to the sample test readme.txt: ";
-    int folderCapacity; 
-    cin >> folderCapacity;
-
-    filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT");
-
-    cout << "\n-------------------------------------------------------------------------\n";
-    cout << "\n1: Worst-Fit using Priority Queue:\n";
-    worstFitPQCaller(folderCapacity, files, testNo);
-
-    cout << "\n-------------------------------------------------------------------------\n";
-    cout << "\n1.1: Worst-Fit using Linear Search:\n";
-    worstFitLinearCaller(folderCapacity, files, testNo);
-
-    cout << "\n-------------------------------------------------------------------------\n";
-    cout << "\n2: Worst-Fit Decreasing using Priority Queue:\n";
-    worstFitDecreasingPQCaller(folderCapacity, files, testNo);
-
-    cout << "\n-------------------------------------------------------------------------\n";
-    cout << "\n2.1: Worst-Fit Decreasing using Linear Search:\n";
-    WFDLinearCaller(folderCapacity, files, testNo);
-
-    cout << "\n-------------------------------------------------------------------------\n";
-    cout << "\n3: First-Fit Decreasing: \n";
-    FirstFitDecreasing(folderCapacity, files, testNo);
-
-    cout << "\n-------------------------------------------------------------------------\n";
-    cout << "\n4: Folder Filling Algorithm:\n";
-    folderFilling(folderCapacity, files, testNo);
-
-
-    //rest of algorithms should be called here
-    return 0;
-}
-
+﻿#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <algorithm>
+#include <fstream>
+#include <filesystem>
+#include<queue>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <functional>
+#include <iomanip>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <cstdlib>
+#include <cmath>
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <csignal>
+#elif defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#include "SoundPacking.h"
+#include "AllocationCounter.h"   // threadAllocations, runTask counts the difference over an algorithm
+
+using namespace std;
+namespace fs = filesystem;
+
+// the placement structures come from the packing library
+using soundpacking::lowestBit;
+using soundpacking::highestBit;
+using LevelBitmap = soundpacking::LevelBitmap<>;
+using CapacityIndex = soundpacking::CapacityIndex<>;
+using soundpacking::LowerBounds;
+using soundpacking::FolderFillingStats;
+
+// every engine hands its folders back as file indexes in one compressed sparse row table,
+// allocated from the arena of the thread running the algorithm
+using FolderTable = soundpacking::FolderTable<int, pmr::polymorphic_allocator<int>>;
+using FileSpan = soundpacking::Span<const int>;    // the file indexes of one folder
+
+
+//########################### HELPER FUNCTIONS ###################################
+
+// Folder structure to represent each folder while it is filled, its files are in a FolderTable
+struct Folder {
+    int remainingCapacity = 0;                  // Remaining capacity of the folder
+    int id = 0;                                 // in the order the folders were created
+};
+
+// the folder tables of the algorithm the thread runs, runTask releases it all at once when the algorithm is done.
+// not thread safe: tables filled on other threads (the shards) stay on the default resource
+thread_local pmr::monotonic_buffer_resource resultArena;
+
+// engine used by folderFilling to solve each folder
+enum class DPEngine {
+    Table,      // full (n+1)*(C+1) int table
+    Bitset,     // reachable sums as bits, checkpointed rows for backtracking
+    Sparse      // only the distinct reachable sums, does not grow with the duration resolution
+};
+
+// resolution of the durations read from a catalog
+enum class DurationPrecision {
+    Auto,           // milliseconds when some duration has them, seconds otherwise
+    Seconds,        // sub-second parts are dropped
+    Milliseconds
+};
+
+// how processFiles puts an audio file into its output folder
+enum class MaterializeMode {
+    Copy,           // fs::copy, a full copy of the audio
+    Hardlink,       // another name for the same file, same filesystem only
+    Reflink,        // copy-on-write clone (FICLONE), btrfs/xfs and similar
+    CopyRange,      // in-kernel copy_file_range, no round trip through user space
+    Symlink,        // link to the input file
+    MetadataOnly    // only the _metadata.txt files, no audio
+};
+
+// run options, set from the command line (e.g. --dp=bitset), defaults keep the original behaviour
+struct RunOptions {
+    DPEngine dpEngine = DPEngine::Table;
+    bool dpEngineChosen = false;    // --dp given, otherwise millisecond catalogs use the sparse engine
+    size_t dpStates = soundpacking::SparseSubsetSum<>::defaultMaxStates;  // sparse engine: states before it falls back to meet in the middle or epsilon
+    double epsilon = soundpacking::SparseSubsetSum<>::defaultEpsilon;    // sparse engine: first epsilon of the fallback, a fraction of the capacity
+    DurationPrecision precision = DurationPrecision::Auto;
+    MaterializeMode materialize = MaterializeMode::Copy;
+    int ioWorkers = max(1, (int)thread::hardware_concurrency());   // 0 writes folders on the main thread
+    int ioQueue = 64;                                               // folders waiting for a worker
+    bool planOnly = false;          // write one manifest per algorithm instead of the folders
+    string applyPlan;               // manifest to turn into folders, skips packing entirely
+    int jobs = 1;                   // algorithms packed side by side, 1 runs them one after the other
+    vector<string> algorithms;      // ids of the algorithms to run (1, 1.1, 2 ...), empty runs all of them
+    string metricsPath;             // where to write the phase times and counters, nothing when empty
+    bool metricsPrometheus = false; // Prometheus text format instead of JSON
+    bool stopAtBound = false;       // skip or stop the DP engines once a faster one meets the lower bound
+    string streamPath;              // catalog entries packed as they arrive ("-" for stdin), no catalog is read
+    bool streamBestFit = false;     // Best-Fit over the open folders instead of Worst-Fit
+    int streamCloseAt = 95;         // percent of the capacity that closes a folder
+    int streamMaxAge = 0;           // seconds a folder may stay open, 0 for no limit
+    int streamMaxOpen = 256;        // the fullest folder is closed to open one more
+    int streamFollow = 0;           // seconds to wait for a growing file, 0 stops at its end
+    string testNo;                  // --test, sample of the audio files in streaming mode, no prompt for it otherwise
+    int capacity = 0;               // --capacity, folder capacity in seconds in streaming mode, the one written by --sweep
+    vector<string> sweep;           // --sweep capacities, SECONDS[.mmm] or FROM-TO:STEP, packed from one read and sort
+    string servePath;               // --serve, Unix domain socket of the packing server
+    int batchWindow = 2;            // milliseconds the server waits for more requests to answer with the first one
+    int shards = 0;                 // sharded mode: the catalog is packed as this many shards in parallel
+    int repairBelow = 90;           // sharded folders filled below this percent are packed again
+    bool skipUnsharded = false;     // no unsharded run to compare with (the DP on a huge catalog)
+    bool planCache = true;          // replay the plan of an earlier run with the same catalog, capacity and algorithm
+    bool scan = false;              // catalog from the MP3 headers of INPUT/Audios instead of AudiosInfo.txt
+    int scanThreads = 0;            // threads scanning the MP3 files, 0 for one per core
+};
+RunOptions options;
+
+// what the materialization actually did, bytes referenced is the size of every placed file
+// (updated by the I/O workers)
+struct MaterializeStats {
+    atomic<long long> bytesWritten{ 0 };
+    atomic<long long> bytesReferenced{ 0 };
+    atomic<int> fallbacks{ 0 };     // files that needed a plain copy because the mode failed
+};
+MaterializeStats materializeStats;
+
+// instrumentation: time per phase and counters, per run and per algorithm (--metrics writes them out).
+// a phase may run inside another one (backtrack inside pack, materialize inside write_folder),
+// I/O phases are summed over the worker threads so they can add up to more than the wall time
+enum class Phase { Parse, Sort, Pack, Backtrack, Submit, IOWait, WriteFolder, CreateDirectory, Materialize, Sync, Count };
+const char* phaseNames[] = { "parse", "sort", "pack", "backtrack", "submit", "io_wait", "write_folder", "create_directory", "materialize", "sync" };
+
+enum class Counter {
+    DPCells,            // DP cells evaluated (a bit of a bitset row counts as a cell)
+    HeapOperations,     // push and pop on the folder heaps
+    FolderScans,        // folders (or index nodes) looked at to place a file
+    BytesCopied,        // audio bytes actually written
+    FilesOpened,        // audio and metadata files opened for writing or copying
+    FilesPlaced,
+    FoldersWritten,
+    FilesKept,          // already in the right folder from an earlier run
+    FilesMoved,         // renamed from another folder of an earlier run
+    FilesRemoved,       // files and folders of an earlier run the new plan does not have
+    Allocations,        // heap allocations on the thread running the algorithm (not the I/O workers or shards)
+    BytesScanned,       // MP3 bytes (4 KB pages) looked at to find the durations
+    Count
+};
+const char* counterNames[] = { "dp_cells", "heap_operations", "folder_scans", "bytes_copied", "files_opened", "files_placed", "folders_written",
+    "files_kept", "files_moved", "files_removed", "allocations", "bytes_scanned" };
+
+// what one scope (the run, or one algorithm) spent and counted, atomics since the I/O workers
+// add to the scope of the folder they write
+struct Metrics {
+    string scope;
+    atomic<long long> phaseNanoseconds[(int)Phase::Count];
+    atomic<long long> phaseCalls[(int)Phase::Count];
+    atomic<long long> counters[(int)Counter::Count];
+
+    Metrics()
+    {
+        for (auto& value : phaseNanoseconds) value = 0;
+        for (auto& value : phaseCalls) value = 0;
+        for (auto& value : counters) value = 0;
+    }
+};
+
+// every scope of the run, a deque so scopes keep their address while others are added
+struct MetricsRegistry {
+    mutex lock;
+    deque<Metrics> scopes;
+
+    Metrics& add(const string& scope)
+    {
+        lock_guard<mutex> guard(lock);
+        scopes.emplace_back();
+        scopes.back().scope = scope;
+        return scopes.back();
+    }
+};
+MetricsRegistry metricsRegistry;
+Metrics& runMetrics = metricsRegistry.add("run");
+
+// the scope the thread is working for, the run unless a MetricsScope says otherwise
+thread_local Metrics* currentMetrics = nullptr;
+Metrics& metrics()
+{
+    return currentMetrics ? *currentMetrics : runMetrics;
+}
+
+struct MetricsScope {
+    Metrics* previous;
+    MetricsScope(Metrics& scope) : previous(currentMetrics) { currentMetrics = &scope; }
+    ~MetricsScope() { currentMetrics = previous; }
+};
+
+void count(Counter counter, long long amount = 1)
+{
+    metrics().counters[(int)counter].fetch_add(amount, memory_order_relaxed);
+}
+
+// adds the time from its construction to stop() (or the end of its scope) to a phase
+struct PhaseTimer {
+    Phase phase;
+    Metrics& target;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool running = true;
+
+    PhaseTimer(Phase phase) : phase(phase), target(metrics()) {}
+
+    // returns the elapsed nanoseconds
+    long long stop()
+    {
+        long long nanoseconds = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+        if (running)
+        {
+            target.phaseNanoseconds[(int)phase].fetch_add(nanoseconds, memory_order_relaxed);
+            target.phaseCalls[(int)phase].fetch_add(1, memory_order_relaxed);
+            running = false;
+        }
+        return nanoseconds;
+    }
+
+    ~PhaseTimer() { stop(); }
+};
+
+// time the packing library measured for a phase, over "calls" intervals (e.g. a backtrack per folder)
+void addPhaseTime(Phase phase, long long nanoseconds, long long calls)
+{
+    metrics().phaseNanoseconds[(int)phase].fetch_add(nanoseconds, memory_order_relaxed);
+    metrics().phaseCalls[(int)phase].fetch_add(calls, memory_order_relaxed);
+}
+
+// Comparator for priority queue (max-heap)
+// Ensures the folder with the most remaining capacity is at the top
+struct Compare {
+    bool operator()(const Folder& f1, const Folder& f2) {
+        return f1.remainingCapacity < f2.remainingCapacity; // Max-heap
+    }
+};
+
+// reads the digits at p as a number, p ends on the first character after them
+// returns false when there is no digit at p
+bool parseNumber(const char*& p, const char* end, int& number)
+{
+    const char* start = p;
+    number = 0;
+    while (p < end && *p >= '0' && *p <= '9')
+    {
+        number = number * 10 + (*p - '0');
+        p++;
+    }
+    return p != start;
+}
+
+// parses a fraction of a second after the '.' at p into milliseconds (.5 is 500), digits past the third are dropped
+bool parseMilliseconds(const char*& p, const char* end, int& milliseconds)
+{
+    int digits = 0;
+    milliseconds = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++)
+    {
+        if (digits < 3) milliseconds = milliseconds * 10 + (*p - '0');
+        digits++;
+    }
+    for (int i = digits; i < 3; i++) milliseconds *= 10;
+    return digits > 0;
+}
+
+// parses HH:MM:SS or HH:MM:SS.mmm at p into milliseconds, p ends on the first character after it
+// returns false when the text is not a duration
+bool parseDuration(const char*& p, const char* end, long long& milliseconds)
+{
+    int hours, minutes, seconds, fraction = 0;
+    if (!parseNumber(p, end, hours) || p == end || *p++ != ':') return false;
+    if (!parseNumber(p, end, minutes) || p == end || *p++ != ':') return false;
+    if (!parseNumber(p, end, seconds)) return false;
+    if (p < end && *p == '.' && !parseMilliseconds(++p, end, fraction)) return false;
+    milliseconds = (hours * 3600LL + minutes * 60 + seconds) * 1000 + fraction;
+    return true;
+}
+
+// every duration and capacity is an int in these units per second: 1, or 1000 at millisecond precision
+// (readCatalog or scanCatalog picks it). sums over many files are 64-bit
+int durationScale = 1;
+
+// a parsed duration in the current units, sub-second parts are dropped at second precision
+long long toDurationUnits(long long milliseconds)
+{
+    return durationScale == 1000 ? milliseconds : milliseconds / 1000;
+}
+
+// convert HH:MM:SS to seconds
+int timeToSeconds(const string& time) 
+{
+    const char* p = time.data();
+    long long milliseconds = 0;
+    parseDuration(p, p + time.size(), milliseconds);
+    return (int)(milliseconds / 1000);
+}
+
+//converts a duration to time format (HH:MM:SS, HH:MM:SS.mmm at millisecond precision) for filling metadata file
+string durationToTime(long long duration) 
+{
+    long long totalSeconds = duration / durationScale;
+    long long hours = totalSeconds / 3600;
+    int minutes = (totalSeconds % 3600) / 60;
+    int seconds = totalSeconds % 60;
+
+    string result =
+        (hours < 10 ? "0" : "") + to_string(hours) + ":" +
+        (minutes < 10 ? "0" : "") + to_string(minutes) + ":" +
+        (seconds < 10 ? "0" : "") + to_string(seconds);
+
+    if (durationScale == 1000)
+    {
+        string milliseconds = to_string(duration % 1000);
+        result += "." + string(3 - milliseconds.size(), '0') + milliseconds;
+    }
+    return result;
+}
+
+// folder capacity given in seconds (SECONDS or SECONDS.mmm) in the current units,
+// false when it is not a number or does not fit the DP tables
+bool parseCapacity(const string& text, int& capacity)
+{
+    const char* p = text.data();
+    const char* end = p + text.size();
+    int seconds, milliseconds = 0;
+    if (text.size() > 12 || !parseNumber(p, end, seconds)) return false;
+    if (p < end && *p == '.' && !parseMilliseconds(++p, end, milliseconds)) return false;
+    long long units = (long long)seconds * durationScale + (durationScale == 1000 ? milliseconds : 0);
+    if (p != end || units >= INT32_MAX) return false;
+    capacity = (int)units;
+    return true;
+}
+
+// 64-bit FNV-1a of a byte range, chained through hash
+uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) //θ(size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+// Sort files in descending order
+bool compareFiles(const pair<string, int>& a, const pair<string, int>& b) {
+    return a.second > b.second;
+}
+void sortFiles(vector<pair<string, int>>& files) {
+    sort(files.begin(), files.end(), compareFiles);
+}
+
+// packs the files with a placement policy of the packing library (the file index is the key),
+// folders gets the file indexes of every folder (from its allocator). returns the index operations
+//TIME COMPLEXITY: θ(n) + the policy
+template <class Policy>
+long long packWithPolicy(int folderCapacity, const vector<int>& durations, FolderTable& folders)
+{
+    vector<soundpacking::Item<int, int>> items(durations.size());
+    for (int i = 0; i < durations.size(); i++) //θ(n)
+    {
+        items[i] = { i, durations[i] };
+    }
+    auto packing = soundpacking::pack<Policy>(items, folderCapacity, folders.get_allocator());
+    folders = move(packing.folders); // same resource, the arrays are taken over
+    return packing.operations;
+}
+
+
+#ifdef __linux__
+// clones source into destination sharing the same disk blocks, fails where the filesystem has no reflinks
+bool reflinkFile(const string& sourcePath, const string& destinationPath)
+{
+    int source = open(sourcePath.c_str(), O_RDONLY);
+    if (source < 0) return false;
+    int destination = open(destinationPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (destination < 0)
+    {
+        close(source);
+        return false;
+    }
+    bool cloned = ioctl(destination, FICLONE, source) == 0;
+    close(source);
+    close(destination);
+    return cloned;
+}
+
+// copies the file inside the kernel, fails on kernels or filesystems that do not support it
+bool copyFileRange(const string& sourcePath, const string& destinationPath, long long size)
+{
+    int source = open(sourcePath.c_str(), O_RDONLY);
+    if (source < 0) return false;
+    int destination = open(destinationPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (destination < 0)
+    {
+        close(source);
+        return false;
+    }
+    long long remaining = size;
+    while (remaining > 0)
+    {
+        ssize_t copied = copy_file_range(source, nullptr, destination, nullptr, remaining, 0);
+        if (copied <= 0) break;
+        remaining -= copied;
+    }
+    close(source);
+    close(destination);
+    return remaining == 0;
+}
+#endif
+
+// puts one audio file in its output folder using options.materialize.
+// a mode that fails (other filesystem, no reflink support, no symlink rights...) falls back
+// to the next cheapest one and finally to fs::copy, so the output is always complete
+void materializeFile(const string& sourcePath, const string& destinationPath, long long size)
+{
+    materializeStats.bytesReferenced += size;
+
+    MaterializeMode mode = options.materialize;
+    if (mode == MaterializeMode::MetadataOnly) return;
+
+    error_code error;
+    if (mode != MaterializeMode::Copy)
+    {
+        // never write through an old link into the input file
+        fs::remove(destinationPath, error);
+    }
+
+    if (mode == MaterializeMode::Hardlink || mode == MaterializeMode::Symlink)
+    {
+        if (mode == MaterializeMode::Hardlink)
+            fs::create_hard_link(sourcePath, destinationPath, error);
+        else
+            fs::create_symlink(fs::absolute(sourcePath).lexically_normal(), destinationPath, error);
+        if (!error) return;
+        materializeStats.fallbacks++;
+        mode = MaterializeMode::Copy;
+    }
+
+#ifdef __linux__
+    if (mode == MaterializeMode::Reflink)
+    {
+        count(Counter::FilesOpened, 2);
+        if (reflinkFile(sourcePath, destinationPath)) return;
+        mode = MaterializeMode::CopyRange;
+    }
+    if (mode == MaterializeMode::CopyRange)
+    {
+        count(Counter::FilesOpened, 2);
+        if (copyFileRange(sourcePath, destinationPath, size))
+        {
+            materializeStats.bytesWritten += size;
+            count(Counter::BytesCopied, size);
+            if (options.materialize != MaterializeMode::CopyRange) materializeStats.fallbacks++;
+            return;
+        }
+        materializeStats.fallbacks++;
+    }
+#else
+    if (mode != MaterializeMode::Copy) materializeStats.fallbacks++;
+#endif
+
+    count(Counter::FilesOpened, 2);
+    fs::copy(sourcePath, destinationPath, fs::copy_options::overwrite_existing);
+    materializeStats.bytesWritten += size;
+    count(Counter::BytesCopied, size);
+}
+
+// true when the file an earlier run put at path can stay as the placement of sourcePath in the
+// current mode: the same link in symlink mode, the input itself in hardlink mode, otherwise a regular
+// file of its own of the same size not older than its input (a copy is newer; an input rewritten
+// since then is newer than its copy). a placement of another mode is never kept, it is rewritten
+bool placedFileMatches(const string& path, const string& sourcePath, long long size)
+{
+    error_code error;
+    fs::file_status status = fs::symlink_status(path, error);
+    if (error) return false;
+    if (options.materialize == MaterializeMode::Symlink)
+    {
+        return fs::is_symlink(status) && fs::read_symlink(path, error) == fs::absolute(sourcePath).lexically_normal() && !error;
+    }
+    if (!fs::is_regular_file(status) || (long long)fs::file_size(path, error) != size || error) return false;
+    bool sameFile = fs::equivalent(path, sourcePath, error);
+    if (error) return false;
+    if (options.materialize == MaterializeMode::Hardlink) return sameFile;
+
+    // a hardlink of an earlier run shares the input, writing a copy over it would write into the input
+    if (sameFile || fs::hard_link_count(path, error) > 1 || error) return false;
+    fs::file_time_type placed = fs::last_write_time(path, error);
+    if (error) return false;
+    fs::file_time_type input = fs::last_write_time(sourcePath, error);
+    return !error && placed >= input;
+}
+
+// what an algorithm directory held before this run: the audio of every F<n> folder and the
+// F<n>_metadata.txt files. the folders of the new plan are synced against it, so a file already
+// in its folder is kept, a file in another folder is moved and only the rest is written
+struct PreviousOutput {
+    struct PlacedFile {
+        int folderId;
+        bool claimed;       // kept or rewritten by this run, set by the worker of the one folder that has the file
+    };
+    unordered_map<string, PlacedFile> files;    // by audio name, a name is in one folder of a plan
+    unordered_map<int, string> metadata;        // folder id -> text of F<id>_metadata.txt
+    vector<int> folders;                        // every F<n> directory
+    vector<fs::path> strays;                    // anything else in the directory
+
+    // n of "F<n>" followed by suffix, -1 for any other name
+    static int folderIdOf(const string& name, const string& suffix)
+    {
+        if (name.size() < suffix.size() + 2 || name.size() > suffix.size() + 10 || name[0] != 'F') return -1;
+        size_t end = name.size() - suffix.size();
+        if (name.compare(end, string::npos, suffix) != 0) return -1;
+        int folderId = 0;
+        for (size_t i = 1; i < end; i++)
+        {
+            if (name[i] < '0' || name[i] > '9') return -1;
+            folderId = folderId * 10 + (name[i] - '0');
+        }
+        return folderId;
+    }
+
+    //TIME COMPLEXITY: θ(entries of the directory and of its folders)
+    void scan(const string& directory)
+    {
+        error_code error;
+        for (const fs::directory_entry& entry : fs::directory_iterator(directory, error))
+        {
+            string name = entry.path().filename().string();
+            int folderId = folderIdOf(name, "");
+            if (folderId >= 0 && entry.is_directory(error))
+            {
+                folders.push_back(folderId);
+                for (const fs::directory_entry& audio : fs::directory_iterator(entry.path(), error))
+                {
+                    files[audio.path().filename().string()] = { folderId, false };
+                }
+                continue;
+            }
+            folderId = folderIdOf(name, "_metadata.txt");
+            if (folderId >= 0 && entry.is_regular_file(error))
+            {
+                ifstream metadataFile(entry.path());
+                metadata[folderId].assign(istreambuf_iterator<char>(metadataFile), istreambuf_iterator<char>());
+                continue;
+            }
+            strays.push_back(entry.path());
+        }
+    }
+};
+
+// where an algorithm prints its output, cout unless the parallel runner collects it for later
+thread_local ostream* consoleStream = &cout;
+ostream& console()
+{
+    return *consoleStream;
+}
+
+void displayProgressBar(long long current, long long total) {
+    if (consoleStream != &cout) return; // a progress bar means nothing in collected output
+
+    const int barWidth = 50; // Width of the progress bar
+    float progress = total == 0 ? 1.0f : (float)current / total;
+
+    cout << "[";
+    int pos = barWidth * progress;
+    for (int i = 0; i < barWidth; ++i) {
+        if (i < pos) cout << "=";
+        else if (i == pos) cout << ">";
+        else cout << " ";
+    }
+    cout << "] " << int(progress * 100.0) << " %\r";
+    cout.flush();
+}
+
+// milliseconds elapsed since start
+double millisecondsSince(chrono::high_resolution_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::high_resolution_clock::now() - start).count();
+}
+
+// the folders written for one algorithm run, so several algorithms can share the I/O pipeline
+struct IOBatch {
+    atomic<long long> submittedBytes{ 0 }, completedBytes{ 0 };
+    atomic<long long> submittedFolders{ 0 }, completedFolders{ 0 };
+    atomic<long long> completedFiles{ 0 };
+    bool started = false;
+    chrono::high_resolution_clock::time_point start;   // first folder submitted
+    double milliseconds = 0;                            // first submit to last folder written
+    exception_ptr firstError;
+    Metrics* metrics = &::metrics();                    // scope the workers count this batch in
+
+    // incremental sync of the algorithm directory, scanned when the first folder is submitted
+    string directory;                                   // ../OUTPUT/<algorithm>/
+    PreviousOutput previous;
+    unordered_set<int> submittedFolderIds;
+    atomic<long long> keptFiles{ 0 }, movedFiles{ 0 }, removedFiles{ 0 };
+
+    // queued FolderJobs point to the batch: one left by an exception before finishBatch
+    // still waits for the workers to be done with its folders
+    ~IOBatch();
+};
+
+// one output folder: where it goes and the files (with their audio sizes) to put in it
+struct FolderJob {
+    string directory;                   // ../OUTPUT/<algorithm>/F<n>
+    int folderId = 0;                   // the n of F<n>
+    string inputDirectory;              // ../INPUT/Audios/
+    vector<pair<string, int>> files;
+    vector<long long> sizes;
+    IOBatch* batch = nullptr;
+
+    long long bytes() const
+    {
+        long long total = 0;
+        for (long long size : sizes) total += size;
+        return total;
+    }
+};
+
+// I/O stage: folders are written by a pool of worker threads fed through a bounded queue,
+// so packing and the rest of the folders go on while the audio is being copied.
+// each folder is written exactly as before, only folders are written side by side.
+// with 0 workers every folder is written right away on the calling thread.
+struct IOPipeline {
+    vector<thread> workers;
+    deque<FolderJob> queue;
+    size_t queueCapacity = 1;
+    bool stopping = false;
+    mutex lock;
+    condition_variable queueNotEmpty, queueNotFull, folderDone;
+
+    void start(int workerCount, int capacity)
+    {
+        queueCapacity = max(1, capacity);
+        for (int i = 0; i < workerCount; i++)
+            workers.emplace_back([this] { workerLoop(); });
+    }
+
+    void stop()
+    {
+        {
+            lock_guard<mutex> guard(lock);
+            stopping = true;
+        }
+        queueNotEmpty.notify_all();
+        for (thread& worker : workers) worker.join();
+        workers.clear();
+    }
+
+    // queues a folder, blocks while the queue is full
+    void submit(FolderJob job)
+    {
+        IOBatch& batch = *job.batch;
+        if (!batch.started)
+        {
+            batch.started = true;
+            batch.start = chrono::high_resolution_clock::now();
+            batch.directory = job.directory.substr(0, job.directory.rfind('/') + 1);
+            PhaseTimer syncTimer(Phase::Sync);
+            batch.previous.scan(batch.directory);
+        }
+        batch.submittedFolderIds.insert(job.folderId);
+        batch.submittedBytes += job.bytes();
+        batch.submittedFolders++;
+
+        if (workers.empty())
+        {
+            runJob(job);
+            return;
+        }
+        {
+            unique_lock<mutex> guard(lock);
+            queueNotFull.wait(guard, [this] { return queue.size() < queueCapacity; });
+            queue.push_back(move(job));
+        }
+        queueNotEmpty.notify_one();
+    }
+
+    // blocks until the workers are done with every folder of the batch
+    void waitForBatch(IOBatch& batch)
+    {
+        unique_lock<mutex> guard(lock);
+        folderDone.wait(guard, [&batch] { return batch.completedFolders >= batch.submittedFolders; });
+    }
+
+    // waits for every folder of the batch while the progress bar follows the written bytes,
+    // then reports the throughput of the batch (and rethrows the first I/O error, if any)
+    void finishBatch(IOBatch& batch)
+    {
+        PhaseTimer timer(Phase::IOWait);
+        {
+            unique_lock<mutex> guard(lock);
+            while (batch.completedFolders < batch.submittedFolders)
+            {
+                displayProgressBar(batch.completedBytes, batch.submittedBytes);
+                folderDone.wait_for(guard, chrono::milliseconds(100));
+            }
+        }
+        displayProgressBar(batch.submittedBytes, batch.submittedBytes);
+
+        if (batch.started)
+        {
+            batch.milliseconds = millisecondsSince(batch.start);
+            double seconds = batch.milliseconds / 1000;
+            if (seconds > 0)
+            {
+                console() << "\nI/O: " << batch.submittedBytes / 1048576.0 / seconds << " MB/s, "
+                    << batch.completedFiles / seconds << " files/s ("
+                    << workers.size() << " workers)";
+            }
+        }
+
+        if (batch.firstError)
+        {
+            rethrow_exception(batch.firstError);
+        }
+        if (batch.started)
+        {
+            removeStaleOutput(batch);
+            console() << "\nSync: " << batch.completedFiles - batch.keptFiles - batch.movedFiles << " files placed, "
+                << batch.keptFiles << " kept, " << batch.movedFiles << " moved, " << batch.removedFiles << " entries removed";
+        }
+    }
+
+    // once every folder is written: removes what the earlier run had and the new plan does not,
+    // files left in a folder that stays, folders past the new folder count and anything else
+    //TIME COMPLEXITY: θ(entries of the earlier run)
+    void removeStaleOutput(IOBatch& batch)
+    {
+        PhaseTimer timer(Phase::Sync);
+        PreviousOutput& previous = batch.previous;
+        error_code error;
+        long long removed = 0;
+        auto removeAll = [&](const fs::path& path) {
+            uintmax_t entries = fs::remove_all(path, error);
+            if (!error) removed += entries;
+        };
+        for (const auto& file : previous.files)
+        {
+            if (!file.second.claimed && batch.submittedFolderIds.count(file.second.folderId))
+                removed += fs::remove(batch.directory + "F" + to_string(file.second.folderId) + "/" + file.first, error);
+        }
+        for (const auto& metadata : previous.metadata)
+        {
+            if (!batch.submittedFolderIds.count(metadata.first))
+                removed += fs::remove(batch.directory + "F" + to_string(metadata.first) + "_metadata.txt", error);
+        }
+        for (int folderId : previous.folders)
+        {
+            if (!batch.submittedFolderIds.count(folderId))
+                removeAll(batch.directory + "F" + to_string(folderId));
+        }
+        for (const fs::path& stray : previous.strays)
+        {
+            removeAll(stray);
+        }
+        batch.removedFiles += removed;
+        count(Counter::FilesRemoved, removed);
+        previous = PreviousOutput();
+    }
+
+    void workerLoop()
+    {
+        while (true)
+        {
+            FolderJob job;
+            {
+                unique_lock<mutex> guard(lock);
+                queueNotEmpty.wait(guard, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return; // stopping and nothing left to write
+                job = move(queue.front());
+                queue.pop_front();
+            }
+            queueNotFull.notify_one();
+            runJob(job);
+        }
+    }
+
+    // writes a folder on this thread. a failed folder still counts as completed, so waitForBatch returns,
+    // and its error is kept for finishBatch to rethrow
+    void runJob(const FolderJob& job)
+    {
+        try
+        {
+            writeFolder(job);
+        }
+        catch (...)
+        {
+            lock_guard<mutex> guard(lock);
+            if (!job.batch->firstError) job.batch->firstError = current_exception();
+            job.batch->completedBytes += job.bytes();
+            job.batch->completedFolders++;
+        }
+        {
+            lock_guard<mutex> guard(lock); // finishBatch cant miss the notification
+        }
+        folderDone.notify_all();
+    }
+
+    // creates the folder, places its audio and writes its _metadata.txt
+    void writeFolder(const FolderJob& job)
+    {
+        MetricsScope scope(*job.batch->metrics);
+        PhaseTimer timer(Phase::WriteFolder);
+        if (!fs::exists(job.directory))
+        {
+            PhaseTimer createTimer(Phase::CreateDirectory);
+            fs::create_directory(job.directory);
+
+        }
+
+        //cout << "Folder " << folderCount << ":\n";
+        string metadata;
+        long long currentFolderDuration = 0;
+
+        for (size_t i = 0; i < job.files.size(); i++)
+        {
+            const string& fileName = job.files[i].first;
+            int fileDuration = job.files[i].second;
+
+            if (!syncFile(job, i))
+            {
+                PhaseTimer materializeTimer(Phase::Materialize);
+                materializeFile(job.inputDirectory + fileName, job.directory + "/" + fileName, job.sizes[i]);
+            }
+
+            //print on console and add file to metadata.txt
+            metadata += fileName + " " + durationToTime(fileDuration) + "\n";
+
+            currentFolderDuration += fileDuration;
+        }
+
+        //cout << durationToTime(currentFolderDuration) << "\n\n";
+        metadata += durationToTime(currentFolderDuration) + "\n";
+
+        // the metadata is only written again when it changed
+        auto previousMetadata = job.batch->previous.metadata.find(job.folderId);
+        if (previousMetadata == job.batch->previous.metadata.end() || previousMetadata->second != metadata)
+        {
+            ofstream metadataFile(job.directory + "_metadata.txt");
+            count(Counter::FilesOpened);
+            metadataFile << metadata;
+        }
+
+        count(Counter::FoldersWritten);
+        job.batch->completedBytes += job.bytes();
+        job.batch->completedFiles += job.files.size();
+        job.batch->completedFolders++;
+    }
+
+    // keeps file i of the folder where an earlier run put it, or moves it there from another folder.
+    // false when it still has to be materialized (a stale copy in this folder is removed first)
+    bool syncFile(const FolderJob& job, size_t i)
+    {
+        PreviousOutput& previous = job.batch->previous;
+        const string& fileName = job.files[i].first;
+        auto placed = previous.files.find(fileName);
+        if (placed == previous.files.end() || options.materialize == MaterializeMode::MetadataOnly) return false;
+
+        bool sameFolder = (placed->second.folderId == job.folderId);
+        string placedPath = job.batch->directory + "F" + to_string(placed->second.folderId) + "/" + fileName;
+        string destinationPath = job.directory + "/" + fileName;
+        error_code error;
+        if (!placedFileMatches(placedPath, job.inputDirectory + fileName, job.sizes[i]))
+        {
+            if (sameFolder)
+            {
+                placed->second.claimed = true; // written again below, not stale
+                fs::remove(destinationPath, error);
+            }
+            return false;
+        }
+        if (!sameFolder)
+        {
+            fs::rename(placedPath, destinationPath, error);
+            if (error) return false; // left behind and removed with the stale files
+        }
+        placed->second.claimed = true;
+        materializeStats.bytesReferenced += job.sizes[i];
+        count(sameFolder ? Counter::FilesKept : Counter::FilesMoved);
+        (sameFolder ? job.batch->keptFiles : job.batch->movedFiles)++;
+        return true;
+    }
+};
+IOPipeline ioPipeline;
+
+IOBatch::~IOBatch()
+{
+    ioPipeline.waitForBatch(*this);
+}
+
+// a file mapped read only in memory (read into a buffer where mapping is not available)
+struct MappedFile {
+    const char* data = nullptr;
+    size_t size = 0;
+    vector<char> buffer;        // fallback copy of the file
+#if defined(__unix__) || defined(__APPLE__)
+    void* mapping = nullptr;
+#elif defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE, mapping = nullptr;
+#endif
+
+    // sequential: the whole file is read front to back (read ahead), otherwise only some pages of it
+    bool open(const string& path, bool sequential = true)
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        int descriptor = ::open(path.c_str(), O_RDONLY);
+        if (descriptor < 0) return false;
+        struct stat status;
+        if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+        {
+            void* address = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+            if (address != MAP_FAILED)
+            {
+                madvise(address, status.st_size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+                mapping = address;
+                data = (const char*)address;
+                size = status.st_size;
+            }
+        }
+        ::close(descriptor);
+        if (data) return true;
+#elif defined(_WIN32)
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+            sequential ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+        {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            if (data)
+            {
+                size = (size_t)fileSize.QuadPart;
+                return true;
+            }
+        }
+#endif
+        // empty file or no mapping, read it the plain way
+        ifstream input(path, ios::binary);
+        if (!input.is_open()) return false;
+        buffer.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+        data = buffer.data();
+        size = buffer.size();
+        return true;
+    }
+
+    ~MappedFile()
+    {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapping) munmap(mapping, size);
+#elif defined(_WIN32)
+        if (mapping && data) UnmapViewOfFile(data);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#endif
+    }
+};
+
+// the files an algorithm packs: their durations, and the catalog index of each one when they are
+// not in catalog order. the engines only see the durations and hand back positions in them,
+// names are looked up in the catalog when a folder is written
+struct FileList {
+    vector<int> durations;
+    vector<int> order;                  // order[i] is the catalog index of durations[i], empty for catalog order
+
+    int size() const { return durations.size(); }
+    int fileIndex(int position) const { return order.empty() ? position : order[position]; }
+};
+
+// the catalog of a test as a struct of arrays: every name back to back in one arena and the
+// durations in a flat array, so nothing on the parsing and sorting path allocates per file.
+// sorting only permutes indexes, the names never move
+struct Catalog {
+    string names;                       // name arena
+    vector<uint32_t> nameOffsets;       // name i is names[nameOffsets[i] .. nameOffsets[i + 1])
+    vector<int32_t> durations;          // in durationScale units
+
+    int size() const { return durations.size(); }
+
+    string_view name(int i) const
+    {
+        return string_view(names.data() + nameOffsets[i], nameOffsets[i + 1] - nameOffsets[i]);
+    }
+
+    // file indexes by decreasing duration, ties end up exactly where sortFiles puts them
+    // (same comparisons on the same sequence, so std::sort makes the same moves)
+    vector<int> decreasingOrder() const //O(nlogn)
+    {
+        vector<int> order(size());
+        for (int i = 0; i < size(); i++) order[i] = i;
+        sort(order.begin(), order.end(), [this](int a, int b) { return durations[a] > durations[b]; });
+        return order;
+    }
+
+    // the durations the algorithms take, in catalog order or in the given order
+    FileList files(vector<int> order = {}) const //θ(n)
+    {
+        FileList result;
+        result.durations.resize(size());
+        for (int i = 0; i < size(); i++)
+        {
+            result.durations[i] = durations[order.empty() ? i : order[i]];
+        }
+        result.order = move(order);
+        return result;
+    }
+};
+Catalog catalog;
+uint64_t catalogHash = 0;               // FNV-1a of AudiosInfo.txt (or of the scanned catalog), the catalog part of the plan cache keys
+
+// plan cache entry the algorithm running on this thread records its plan for, empty when it records nothing
+thread_local string recordingPlanPath;
+
+// plan-only mode: every algorithm writes OUTPUT/<algorithm>.plan instead of its folders.
+// the manifest is line oriented, a small header then one "folder fileIndex duration" line per file
+// (fileIndex is the catalog index), folders are written in order so it can be streamed back.
+// the same manifest goes to the plan cache (recordingPlanPath) when the run is not plan-only
+struct PlanWriter {
+    struct Manifest {
+        ofstream stream;
+        string path;
+        string cachePath;       // where the finished manifest is kept for later runs
+    };
+    mutex lock;
+    unordered_map<string, Manifest> manifests;     // one per algorithm, algorithms may run in parallel
+
+    void add(const string& testNo, const string& algorithm, int folderId, const FileList& files, FileSpan chosenFilesIndexes)
+    {
+        lock_guard<mutex> guard(lock);
+        Manifest& manifest = manifests[algorithm];
+        if (!manifest.stream.is_open())
+        {
+            manifest.cachePath = recordingPlanPath;
+            manifest.path = options.planOnly ? "../Sample Tests/Sample " + testNo + "/OUTPUT/" + algorithm + ".plan" : recordingPlanPath + ".partial";
+            manifest.stream.open(manifest.path);
+            manifest.stream << "sound-packing-plan 1\n";
+            manifest.stream << "test " << testNo << "\n";
+            manifest.stream << "algorithm " << algorithm << "\n";
+        }
+        for (int fileIndex : chosenFilesIndexes)
+        {
+            manifest.stream << folderId << " " << files.fileIndex(fileIndex) << " " << files.durations[fileIndex] << "\n";
+        }
+    }
+
+    // drops the manifest of an algorithm that did not finish
+    void discard(const string& algorithm)
+    {
+        lock_guard<mutex> guard(lock);
+        auto manifest = manifests.find(algorithm);
+        if (manifest == manifests.end()) return;
+        manifest->second.stream.close();
+        fs::remove(manifest->second.path);
+        manifests.erase(manifest);
+    }
+
+    // closes the manifest of an algorithm that finished and puts it in the plan cache,
+    // a manifest that could not be written completely is not cached
+    void finish(const string& algorithm)
+    {
+        lock_guard<mutex> guard(lock);
+        auto manifest = manifests.find(algorithm);
+        if (manifest == manifests.end()) return;
+        Manifest& finished = manifest->second;
+        finished.stream.close();
+        error_code error;
+        if (!finished.cachePath.empty() && finished.stream)
+        {
+            if (options.planOnly)
+                fs::copy_file(finished.path, finished.cachePath, fs::copy_options::overwrite_existing, error);
+            else
+                fs::rename(finished.path, finished.cachePath, error);
+        }
+        if (!options.planOnly) fs::remove(finished.path, error);
+        manifests.erase(manifest);
+    }
+
+    void close()
+    {
+        manifests.clear();
+    }
+};
+PlanWriter planWriter;
+
+// hands one folder of (name, duration) files to the I/O pipeline, with the size of every audio file
+void submitFolder(vector<pair<string, int>> folderFiles, int folderCount, const string& folderName, const string& testNo, IOBatch& batch) {
+    FolderJob job;
+    job.directory = "../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName + "/F" + to_string(folderCount);
+    job.folderId = folderCount;
+    job.inputDirectory = "../Sample Tests/Sample " + testNo + "/INPUT/Audios/";
+    job.batch = &batch;
+    job.files = move(folderFiles);
+    for (const auto& file : job.files)
+    {
+        job.sizes.push_back(fs::file_size(job.inputDirectory + file.first));
+    }
+    ioPipeline.submit(move(job));
+}
+
+//function that copies BATCH OF FILES into a destination folder.
+//this function will not work properly with processing files one by one each call.
+//folderName represents the algorithm you are working on. 
+//e.g: [3] FirstFit Decreasing. CHECK SAMPLE TESTS
+//the folder is handed to the I/O pipeline, ioPipeline.finishBatch(batch) waits until it is written
+//(in plan-only mode it only goes into the algorithm's manifest).
+//chosenFilesIndexes are positions in files, the names are looked up in the catalog
+void processFiles(const FileList& files, int folderCount, FileSpan chosenFilesIndexes, string folderName, string testNo, IOBatch& batch) {
+    
+    PhaseTimer timer(Phase::Submit);
+    count(Counter::FilesPlaced, chosenFilesIndexes.size());
+
+    if (options.planOnly || !recordingPlanPath.empty())
+    {
+        planWriter.add(testNo, folderName, folderCount, files, chosenFilesIndexes);
+    }
+    if (options.planOnly)
+    {
+        return;
+    }
+
+    vector<pair<string, int>> folderFiles;
+    folderFiles.reserve(chosenFilesIndexes.size());
+    for (int fileIndex : chosenFilesIndexes) 
+    {
+        folderFiles.emplace_back(string(catalog.name(files.fileIndex(fileIndex))), files.durations[fileIndex]);
+    }
+    submitFolder(move(folderFiles), folderCount, folderName, testNo, batch);
+}
+
+// removes what an algorithm wrote so far (its folders, or its manifest in plan-only mode),
+// once its batch is finished
+void discardOutput(const string& testNo, const string& folderName)
+{
+    fs::remove_all("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName);
+    planWriter.discard(folderName);
+}
+
+// what one algorithm run did, for the summary table
+struct AlgorithmReport {
+    string name;
+    int folderCount = 0;
+    double packMilliseconds = 0;    // the packing engine only
+    double ioMilliseconds = 0;      // writing the folders (overlaps packing for folder filling)
+    string stopped;                 // "skipped" or "aborted" when --stop-at-bound cut it short
+    long long allocations = 0;      // heap allocations of the run on its thread, packing and processFiles
+
+    AlgorithmReport(string name = "", int folderCount = 0, double packMilliseconds = 0, double ioMilliseconds = 0)
+        : name(move(name)), folderCount(folderCount), packMilliseconds(packMilliseconds), ioMilliseconds(ioMilliseconds) {}
+};
+
+
+
+// --stop-at-bound: once any engine's folder count meets the best lower bound of the run, no other
+// engine can do better, so the DP engines that have not started are skipped and the running ones stop
+// at their next folder (engines run in parallel with --jobs)
+struct BoundStop {
+    long long bound = 0;
+    atomic<bool> met{ false };
+};
+BoundStop boundStop;
+
+//########################### WORST FIT (DECREASING) LINEAR ALGORITHM ###################################
+
+// Worst-Fit Linear algorithm - handles file placement and folder filling
+// every file goes to the folder with the most room left, found by scanning them all (soundpacking::WorstFitLinear)
+// folders gets the file indexes of every folder in the order they were created
+// TIME COMPLEXITY O(n*m) where n is the number of files and m is the number of folders
+void worstFitLinear(int folderCapacity, const vector<int>& durations, FolderTable& folders) { // O(n*m)
+	count(Counter::FolderScans, packWithPolicy<soundpacking::WorstFitLinear>(folderCapacity, durations, folders)); //O(n*m)
+}
+
+// Worst-Fit over a bucket queue (soundpacking::WorstFitBuckets): bucket r holds the ids of the folders
+// with r seconds left as a min-heap, and the fullest bucket comes from a hierarchical bitmap.
+// ties go to the lowest id like the linear scan, so every file lands where worstFitLinear puts it,
+// but a placement costs O(log64 C + log m) and never copies a folder or a file name.
+// TIME COMPLEXITY: O(n (log64 C + log m) + C/64) where n is the number of files, m the number of folders
+// and C the folder capacity
+void folderFillingWFBuckets(int folderCapacity, const vector<int>& durations, FolderTable& folders) { //O(n log m)
+	count(Counter::HeapOperations, packWithPolicy<soundpacking::WorstFitBuckets>(folderCapacity, durations, folders)); //O(n (log64 C + log m))
+}
+
+// Worst-Fit (Decreasing) caller for the bucket queue engine, when decreasing the files come already
+// sorted in descending order
+// TIME COMPLEXITY: O(n (log64 C + log m))
+AlgorithmReport worstFitBucketsCaller(int folderCapacity, const FileList& files, string testNo, bool decreasing) { //O(n log m)
+	string folderName = decreasing ? "[2.2] WorstFit Decreasing Bucket Queue" : "[1.2] WorstFit Bucket Queue"; //O(1)
+	filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); //O(1)
+	IOBatch batch; //O(1)
+
+	PhaseTimer packTimer(Phase::Pack); //O(1)
+	FolderTable folders(&resultArena); //O(1)
+	folderFillingWFBuckets(folderCapacity, files.durations, folders); //O(n log m)
+	double packMilliseconds = packTimer.stop() / 1e6; //O(1)
+
+	int folderIndex; //O(1)
+	for (folderIndex = 0; folderIndex < folders.size(); ++folderIndex) { //O(m)
+		processFiles(files, folderIndex + 1, folders[folderIndex], folderName, testNo, batch); //O(1)
+	}
+	ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+	console() << "\nFolder Count: " << folderIndex << endl; //O(1)
+	console() << "Packing time: " << packMilliseconds << " ms" << endl;
+	return { folderName, folderIndex, packMilliseconds, batch.milliseconds };
+}
+
+// Worst-Fit Decreasing Linear caller function - handles the setup and processing of folders
+// files come already sorted in descending order (sorted once in main for every decreasing variant)
+// TIME COMPLEXITY O(n*m) where n is the number of files and m is the number of folders
+AlgorithmReport WFDLinearCaller(int folderCapacity, const FileList& files, string testNo) { //O(n*m)
+	string folderName = "[2.1] WorstFit Decreasing Linear"; //O(1)
+	filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); //O(1)
+	IOBatch batch; //O(1)
+
+    // Apply Worst-Fit Decreasing Linear algorithm
+	PhaseTimer packTimer(Phase::Pack); //O(1)
+	FolderTable folders(&resultArena); //O(1)
+	worstFitLinear(folderCapacity, files.durations, folders); //O(n*m)
+	double packMilliseconds = packTimer.stop() / 1e6; //O(1)
+
+    // Process and save folders
+	int folderCount = 1; //O(1)
+	for (size_t i = 0; i < folders.size(); ++i) { //O(m)
+        // Process files and save metadata
+		processFiles(files, folderCount++, folders[i], folderName, testNo, batch); //O(1)
+    }
+    ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+	console() << "\nFolder Count: " << folderCount - 1 << endl;
+	return { folderName, folderCount - 1, packMilliseconds, batch.milliseconds };
+}
+
+//the caller function for Worst-Fit Linear algorithm
+// TIME COMPLEXITY O(n*m) where n is the number of files and m is the number of folders
+AlgorithmReport worstFitLinearCaller(int folderCapacity, const FileList& files, string testNo) { //O(n*m)
+	string folderName = "[1.1] WorstFit Linear"; //O(1)
+	filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); //O(1)
+	IOBatch batch; //O(1)
+
+
+    // Apply Worst-Fit Decreasing Linear algorithm
+	PhaseTimer packTimer(Phase::Pack); //O(1)
+	FolderTable folders(&resultArena); //O(1)
+	worstFitLinear(folderCapacity, files.durations, folders); //O(n*m)
+	double packMilliseconds = packTimer.stop() / 1e6; //O(1)
+
+    // Process and save folders
+	int folderCount = 1; //O(1)
+	for (size_t i = 0; i < folders.size(); ++i) { //O(m)
+        // Process files and save metadata
+		processFiles(files, folderCount++, folders[i], folderName, testNo, batch); //O(1)
+    }
+    ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+    console() << "\nFolder Count: " << folderCount - 1 << endl; //O(1)
+    return { folderName, folderCount - 1, packMilliseconds, batch.milliseconds }; //O(1)
+}
+
+
+
+//########################### WORST FIT (DECREASING) PQ ALGORITHM ###################################
+
+// Worst-Fit  Algorithm using PRIORITY QUEUE, main logic is here.
+// Function to distribute files into folders using the Worst-Fit algorithm
+// the heap only holds the remaining capacity and the id of every folder, folders gets the file indexes
+// of every folder in the order they come out of the queue at the end
+// TIME COMPLEXITY: O(n log m) where n is the number of files and m is the number of folders
+void worstFitPQ(const vector<int>& durations, int capacity, FolderTable& folders) // O(n log m)
+{
+    // Priority queue to manage folders, sorted by remaining capacity
+	priority_queue<Folder, vector<Folder>, Compare> folderPriorityQueue; // O(1)
+    vector<int> folderOf(durations.size()); // O(n) folder id of every file
+    int folderCount = 0; // O(1)
+    long long heapOperations = 0; // O(1)
+
+    // Loop through all the files
+    for (int fileIndex = 0; fileIndex < durations.size(); fileIndex++) // O(n)
+    {
+        int duration = durations[fileIndex]; // O(1)
+
+        // Check if the largest folder in the queue can fit the file
+        if (!folderPriorityQueue.empty() && folderPriorityQueue.top().remainingCapacity >= duration)//O(log m)
+        {
+            // Update the top folder and re-insert into the queue
+            Folder topFolder = folderPriorityQueue.top(); // O(1)
+            folderPriorityQueue.pop(); // O(log m)
+            folderOf[fileIndex] = topFolder.id; // O(1)
+            topFolder.remainingCapacity -= duration; // O(1)
+            folderPriorityQueue.push(topFolder); // O(log m)
+            heapOperations += 2; // O(1)
+        }
+        else
+        {
+            // Create a new folder and insert into the queue
+            folderOf[fileIndex] = folderCount; // O(1)
+            folderPriorityQueue.push({ capacity - duration, folderCount++ }); // O(log m)
+            heapOperations++; // O(1)
+        }
+    }
+
+    // number the folders in the order the queue gives them back
+    vector<int> position(folderCount); // O(m)
+    for (int i = 0; !folderPriorityQueue.empty(); i++) // O(m)
+    {
+        position[folderPriorityQueue.top().id] = i; // O(1)
+        folderPriorityQueue.pop(); // O(log m)
+        heapOperations++; // O(1)
+    }
+    count(Counter::HeapOperations, heapOperations); // O(1)
+
+    folders.assign(folderCount, durations.size(), [](size_t i) { return (int)i; },
+        [&](size_t i) { return position[folderOf[i]]; }); // θ(n + m)
+}
+
+
+ // Function to apply Worst-Fit Decreasing algorithm
+ // files come already sorted in descending order (the preprocessing step for WFD is done once in main)
+//TIME COMPLEXITY: O(n log m)
+AlgorithmReport worstFitDecreasingPQCaller(int folderCapacity, const FileList& files, string testNo) // O(n log m)
+{
+    // Create a directory for output
+	string folderName = "[2.0] WorstFit Decreasing PQ"; // O(1)
+	fs::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); // O(1)
+	IOBatch batch; // O(1)
+
+    // Apply the Worst-Fit algorithm
+	PhaseTimer packTimer(Phase::Pack); // O(1)
+	FolderTable folders(&resultArena); // O(1)
+	worstFitPQ(files.durations, folderCapacity, folders); // O(n log m)
+	double packMilliseconds = packTimer.stop() / 1e6; // O(1)
+    int folderCount = 1; // O(1) To number folders sequentially
+    
+    // Process each folder to save its results
+    for (size_t i = 0; i < folders.size(); i++) // O(m)
+    {
+        // Copy the files to the folder and save metadata
+		processFiles(files, folderCount, folders[i], folderName, testNo, batch); // O(1)
+		folderCount++; // O(1)
+    }
+    ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+    console() << "\nFolder Count: " << folderCount - 1 << endl; //O(1)  
+    return { folderName, folderCount - 1, packMilliseconds, batch.milliseconds }; //O(1)
+}
+
+/* Complexity Analysis:
+ * - Sorting files: O(n log n), once in main.
+ * - Applying the Worst-Fit algorithm: O(n log m)
+ * Combined complexity: O(n log n), dominated by sorting.
+ */
+
+
+
+ // Function to apply the Worst-Fit algorithm
+AlgorithmReport worstFitPQCaller(int folderCapacity, const FileList& files, string testNo) // O(n log m)
+{
+    // Create a directory for output
+	string folderName = "[1.0] WorstFit PQ"; // O(1)
+	fs::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); // O(1)
+	IOBatch batch; // O(1)
+
+    // Apply the Worst-Fit algorithm
+	PhaseTimer packTimer(Phase::Pack); // O(1)
+	FolderTable folders(&resultArena); // O(1)
+	worstFitPQ(files.durations, folderCapacity, folders); // O(n log m)
+	double packMilliseconds = packTimer.stop() / 1e6; // O(1)
+    int folderCount = 1; // To number folders sequentially
+    // Process each folder to save its results
+	for (size_t i = 0; i < folders.size(); i++) // O(m)
+    {
+        // Copy the files to the folder and save metadata
+		processFiles(files, folderCount, folders[i], folderName, testNo, batch); // O(1)
+		folderCount++; // O(1)
+    }
+    ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+    console() << "\nFolder Count: " << folderCount - 1 << endl; //O(1)
+    return { folderName, folderCount - 1, packMilliseconds, batch.milliseconds }; //O(1)
+}
+
+/* Complexity Analysis:
+ * - Applying the Worst-Fit algorithm: O(n log m)
+ * Combined complexity: O(n log m).
+ */
+
+
+//########################### FIRST FIT DECREASING ALGORITHM ###################################
+
+//Folder filling using First-Fit Decreasing (FFD) algorithm
+//every file goes to the first folder it fits in, scanning from the first one (soundpacking::FirstFitLinear)
+//TIME COMPLEXITY: O(n*m) where n is the number of files and m is the number of folders
+void folderFillingFFD(int folderCapacity, const vector<int>& durations, FolderTable& folders) { //O(n*m)
+    count(Counter::FolderScans, packWithPolicy<soundpacking::FirstFitLinear>(folderCapacity, durations, folders)); //O(n*m)
+}
+
+//Folder filling using First-Fit Decreasing (FFD) with a max-capacity tournament tree (soundpacking::FirstFit)
+//each leaf is a folder and each internal node keeps the largest remaining capacity below it,
+//so the leftmost folder that fits is found by walking down from the root instead of scanning.
+//gives exactly the same folder assignment as folderFillingFFD
+//TIME COMPLEXITY: O(n log m) where n is the number of files and m is the number of folders
+void folderFillingFFDTree(int folderCapacity, const vector<int>& durations, FolderTable& folders) { //O(n log m)
+    count(Counter::FolderScans, packWithPolicy<soundpacking::FirstFit>(folderCapacity, durations, folders)); //O(n log m)
+}
+
+//First-Fit Decreasing (FFD) caller
+//useTree selects the tournament tree engine, otherwise the linear scan is used (to compare both)
+//files come already sorted in descending order (sorted once in main)
+//TIME COMPLEXITY: O(n*m) with the linear scan, O(n log m) with the tree
+//where n is the number of files and m is the number of folders
+AlgorithmReport FirstFitDecreasing(int folderCapacity, const FileList& files, string testNo, bool useTree = false) { //O(n*m)
+	string folderName = useTree ? "[3.1] FirstFit Decreasing Tree" : "[3] FirstFit Decreasing"; //O(1)
+	filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); //O(1)
+    IOBatch batch; //O(1)
+
+    //Assign files to folders using FFD algorithm
+	FolderTable folders(&resultArena); //O(1)
+    PhaseTimer packTimer(Phase::Pack);
+    if (useTree)
+        folderFillingFFDTree(folderCapacity, files.durations, folders); //O(n log m)
+    else
+        folderFillingFFD(folderCapacity, files.durations, folders); //O(n*m)
+    auto packingTime = packTimer.stop();
+
+    //Process each folder
+	int folderIndex; //O(1)
+	for (folderIndex = 0; folderIndex < folders.size(); ++folderIndex) { //O(m)
+		processFiles(files, folderIndex + 1, folders[folderIndex], folderName, testNo, batch); //O(1)
+    }
+    ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+    console() << "\nFolder Count: " << folderIndex << endl; //O(1)
+    console() << "Packing time: " << packingTime / 1e6 << " ms" << endl;
+    return { folderName, folderIndex, packingTime / 1e6, batch.milliseconds };
+}
+
+
+
+//########################### BEST FIT (DECREASING) ALGORITHM ###################################
+
+// Folder filling using Best-Fit: every file goes to the folder it fills the tightest,
+// folders with equal remaining capacity are interchangeable so ties go to the latest one in the bucket.
+// remaining capacities are whole seconds in [0, capacity] so every value gets its own bucket of folders
+// (soundpacking::BestFitBuckets), and the tightest bucket that still fits takes O(log64 C) to find.
+// TIME COMPLEXITY: O(n log64 C + C/64) where n is the number of files and C is the folder capacity
+void folderFillingBFD(int folderCapacity, const vector<int>& durations, FolderTable& folders) { //O(n log64 C)
+    packWithPolicy<soundpacking::BestFitBuckets>(folderCapacity, durations, folders); //O(n log64 C)
+}
+
+// Best-Fit (Decreasing) caller, when decreasing the files come already sorted in descending order
+// TIME COMPLEXITY: O(n log64 C)
+AlgorithmReport BestFitCaller(int folderCapacity, const FileList& files, string testNo, bool decreasing) { //O(n log64 C)
+    string folderName = decreasing ? "[5.1] BestFit Decreasing" : "[5.0] BestFit"; //O(1)
+    filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName); //O(1)
+    IOBatch batch; //O(1)
+
+    //Assign files to folders using the bucketed Best-Fit
+    FolderTable folders(&resultArena); //O(1)
+    PhaseTimer packTimer(Phase::Pack);
+    folderFillingBFD(folderCapacity, files.durations, folders); //O(n log64 C)
+    auto packingTime = packTimer.stop();
+
+    //Process each folder
+    int folderIndex; //O(1)
+    for (folderIndex = 0; folderIndex < folders.size(); ++folderIndex) { //O(m)
+        processFiles(files, folderIndex + 1, folders[folderIndex], folderName, testNo, batch); //O(1)
+    }
+    ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+    console() << "\nFolder Count: " << folderIndex << endl; //O(1)
+    console() << "Packing time: " << packingTime / 1e6 << " ms" << endl;
+    return { folderName, folderIndex, packingTime / 1e6, batch.milliseconds };
+}
+
+
+
+//########################### FOLDER FILLING DP ALGORITHM ###################################
+
+// Folder filling: every folder takes the max duration that fits among the files left, with the
+// subset-sum engine of the packing library --dp picks (soundpacking::fillFolders).
+// every folder is appended to folders as indexes into durations, then onFolder (if any) gets its index
+// so it can be written while the next one is packed.
+// when stop is set it gives up before its next folder (stats.aborted)
+// TIME COMPLEXITY: O(n^2 * m) where n is number of files and m is desired capacity
+FolderFillingStats folderFillingDP(int folderCapacity, const vector<int>& durations, FolderTable& folders,
+    const function<void(int folderIndex)>& onFolder = nullptr, const atomic<bool>* stop = nullptr)
+{
+    auto fill = [&](auto& engine) {
+        return soundpacking::fillFolders(engine, durations, folders, [&](size_t folderIndex) {
+            if (onFolder) onFolder((int)folderIndex);
+        }, stop);
+    };
+    PhaseTimer packTimer(Phase::Pack);
+    FolderFillingStats stats;
+    if (options.dpEngine == DPEngine::Bitset)
+    {
+        soundpacking::BitsetSubsetSum<> engine(folderCapacity);
+        stats = fill(engine); //θ(n * n * m / 64)
+    }
+    else if (options.dpEngine == DPEngine::Sparse)
+    {
+        soundpacking::SparseSubsetSum<> engine(folderCapacity, options.dpStates, options.epsilon);
+        stats = fill(engine); //O(n * n * distinct sums)
+    }
+    else
+    {
+        soundpacking::TableSubsetSum<> engine(folderCapacity, durations.size());
+        stats = fill(engine); //O(n * n * m)
+    }
+    count(Counter::DPCells, stats.cells);
+    addPhaseTime(Phase::Backtrack, stats.backtrackNanoseconds, stats.folderSolves);
+    return stats;
+}
+
+// Folder filling caller
+// TIME COMPLEXITY: FOLDER PROCESSING + O(n^2 * m) where n is number of files and m is desired capacity
+AlgorithmReport folderFilling(int folderCapacity, const FileList& files, string testNo)
+{
+    string folderName = "[4] FolderFilling";  //θ(1)
+    filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName);
+    IOBatch batch;
+
+    int folderCount = 1;   //θ(1)
+
+    //copy chosen files to the current folder, packing goes on while it is written
+    FolderTable folders(&resultArena);
+    FolderFillingStats stats = folderFillingDP(folderCapacity, files.durations, folders,
+        [&](int folderIndex) {
+            processFiles(files, folderCount, folders[folderIndex], folderName, testNo, batch);
+            folderCount++; //θ(1)
+        }, options.stopAtBound ? &boundStop.met : nullptr);
+    long long totalTime = stats.packNanoseconds;
+    long long reusedCells = stats.reusedCells, recomputedCells = stats.recomputedCells;
+
+    ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+    if (stats.aborted)
+    {
+        discardOutput(testNo, folderName);
+        console() << "\nStopped after " << folderCount - 1 << " folders: another engine met the lower bound of "
+            << boundStop.bound << " folders, its output was removed" << endl;
+        AlgorithmReport report{ folderName, 0, totalTime / 1e6, batch.milliseconds };
+        report.stopped = "aborted";
+        return report;
+    }
+    console() << "\nFolder Count: " << folderCount - 1 << endl; //O(1)
+
+    console() << "Total execution time of folderFillingAlgorithm across all iterations: "
+        << totalTime << " nanoseconds" << endl;
+    console() << "Total execution time in milliseconds: "
+        << totalTime / 1e6 << " ms" << endl;
+    console() << "Total execution time in seconds: "
+        << totalTime / 1e9 << " s" << endl;
+    console() << "DP engine: " << stats.engineName
+        << ", peak DP memory: " << stats.dpMemoryBytes / 1024.0 << " KB" << endl;
+    console() << "DP cells reused: " << reusedCells << ", recomputed: " << recomputedCells << " ("
+        << (reusedCells + recomputedCells == 0 ? 0 : reusedCells * 100 / (reusedCells + recomputedCells)) << "% reused)" << endl;
+    if (stats.meetInTheMiddleFolders > 0 || stats.approximateFolders > 0)
+    {
+        console() << "Over the state budget: " << stats.meetInTheMiddleFolders << " folders solved by meet in the middle, "
+            << stats.approximateFolders << " within " << stats.maxEpsilon * 100 << "% of the capacity from their best duration" << endl;
+    }
+    console() << "\n-------------------------------------------------------------------------\n";
+    return { folderName, folderCount - 1, totalTime / 1e6, batch.milliseconds };
+}
+
+
+
+//########################### FOLDER FILLING WITH DURATION CLASSES ###################################
+
+// Folder filling over duration classes (soundpacking::fillFoldersByDuration): every folder takes the max
+// duration that fits like folderFilling, but the work per folder scales with the number of distinct durations.
+// a file longer than the capacity gets a folder of its own first, longest first, like FirstFit Decreasing
+// returns the number of duration classes, -1 when stop was set before it was done
+// TIME COMPLEXITY: O(n log n + f * k * m) where f is the number of folders,
+// k the number of distinct durations and m the desired capacity
+int folderFillingDurationClasses(int folderCapacity, const vector<int>& durations, FolderTable& folders,
+    const atomic<bool>* stop = nullptr)
+{
+    FolderFillingStats stats = soundpacking::fillFoldersByDuration(folderCapacity, durations, folders, stop); //O(n log n + f * k * m)
+    count(Counter::DPCells, stats.cells);
+    return stats.aborted ? -1 : stats.durationClasses;
+}
+
+// Folder filling over duration classes caller
+// TIME COMPLEXITY: FOLDER PROCESSING + O(n log n + f * k * m)
+AlgorithmReport folderFillingClasses(int folderCapacity, const FileList& files, string testNo)
+{
+    string folderName = "[4.1] FolderFilling Duration Classes";  //θ(1)
+    if (durationScale != 1)
+    {
+        // one DP column per unit of capacity and about one class per file, it does not fit in memory
+        console() << "Skipped: duration classes work per second, use 4 with --dp=sparse at millisecond precision" << endl;
+        AlgorithmReport report{ folderName };
+        report.stopped = "skipped";
+        return report;
+    }
+    filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName);
+    IOBatch batch;
+
+    PhaseTimer packTimer(Phase::Pack);
+    FolderTable folders(&resultArena);
+    int numberOfClasses = folderFillingDurationClasses(folderCapacity, files.durations, folders,
+        options.stopAtBound ? &boundStop.met : nullptr);
+    auto packingTime = packTimer.stop();
+    if (numberOfClasses < 0)
+    {
+        // nothing was handed to the I/O pipeline yet
+        discardOutput(testNo, folderName);
+        console() << "\nStopped: another engine met the lower bound of " << boundStop.bound << " folders" << endl;
+        AlgorithmReport report{ folderName, 0, packingTime / 1e6, 0 };
+        report.stopped = "aborted";
+        return report;
+    }
+
+    // the class file indexes point into files, so the names come back when the folders are written
+    int folderIndex; //O(1)
+    for (folderIndex = 0; folderIndex < folders.size(); ++folderIndex) { //O(m)
+        processFiles(files, folderIndex + 1, folders[folderIndex], folderName, testNo, batch); //O(1)
+    }
+    ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+    console() << "\nFolder Count: " << folderIndex << endl; //O(1)
+    console() << "Duration classes: " << numberOfClasses << " (from " << files.size() << " files)" << endl;
+    console() << "Packing time: " << packingTime / 1e6 << " ms" << endl;
+    return { folderName, folderIndex, packingTime / 1e6, batch.milliseconds };
+}
+
+
+
+//########################### MP3 SCANNER ###################################
+
+// what the 4-byte header of an MPEG audio frame says
+struct Mp3Frame {
+    int version = 0;        // 1 for MPEG-1, 2 for MPEG-2, 25 for MPEG-2.5
+    int layer = 0;          // 1, 2 or 3
+    int sampleRate = 0;     // Hz
+    int samples = 0;        // per frame
+    int bytes = 0;          // the whole frame, header included
+    bool mono = false;
+};
+
+// reads the frame header at p, false when it is not one (no sync, a reserved value or the free format)
+//TIME COMPLEXITY: θ(1)
+bool parseMp3Frame(const uint8_t* p, Mp3Frame& frame)
+{
+    static const int bitrates[2][3][15] = {     // kbps by [MPEG-1, MPEG-2 and 2.5][layer - 1][index]
+        { { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+          { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+          { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 } },
+        { { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+          { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+          { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 } } };
+    static const int sampleRates[3] = { 44100, 48000, 32000 };  // MPEG-1, halved for MPEG-2 and quartered for MPEG-2.5
+
+    if (p[0] != 0xFF || (p[1] & 0xE0) != 0xE0) return false;
+    int versionBits = (p[1] >> 3) & 3, layerBits = (p[1] >> 1) & 3;
+    int bitrateIndex = p[2] >> 4, rateIndex = (p[2] >> 2) & 3;
+    if (versionBits == 1 || layerBits == 0 || bitrateIndex == 0 || bitrateIndex == 15 || rateIndex == 3) return false;
+
+    frame.version = versionBits == 3 ? 1 : versionBits == 2 ? 2 : 25;
+    frame.layer = 4 - layerBits;
+    frame.sampleRate = sampleRates[rateIndex] >> (versionBits == 3 ? 0 : versionBits == 2 ? 1 : 2);
+    frame.samples = frame.layer == 1 ? 384 : (frame.layer == 3 && frame.version != 1) ? 576 : 1152;
+    int bitrate = bitrates[frame.version == 1 ? 0 : 1][frame.layer - 1][bitrateIndex] * 1000;
+    int padding = (p[2] >> 1) & 1;
+    frame.bytes = frame.layer == 1 ? (12 * bitrate / frame.sampleRate + padding) * 4
+        : frame.samples / 8 * bitrate / frame.sampleRate + padding;
+    frame.mono = (p[3] >> 6) == 3;
+    return true;
+}
+
+// where the duration of an audio file came from
+enum class DurationSource { XingHeader, VbriHeader, FrameWalk, Failed };
+const char* durationSourceNames[] = { "Xing/Info headers", "VBRI headers", "frame walks" };
+
+struct AudioScan {
+    long long milliseconds = 0;
+    long long bytesRead = 0;        // 4 KB pages of the file looked at
+    DurationSource source = DurationSource::Failed;
+};
+
+const size_t scanPageBytes = 4096;
+
+// duration of an MP3 file from its headers, no audio is decoded: the frame count of the Xing/Info
+// or VBRI header in the first frame when there is one, otherwise the samples of every frame header
+// (the walk jumps from header to header, a byte that is not one is skipped until the next one).
+// ID3v2 tags at the start and the ID3v1 tag at the end are skipped
+//TIME COMPLEXITY: θ(1) with a header, θ(frames) otherwise
+AudioScan scanMp3(const string& path)
+{
+    AudioScan scan;
+    MappedFile file;
+    if (!file.open(path, false) || file.size < 4) return scan;
+    const uint8_t* data = (const uint8_t*)file.data;
+    size_t position = 0, end = file.size;
+
+    // the reads only go forward (the ID3v1 tag is counted at the end), so a page is new when it is past the last one
+    size_t lastPage = SIZE_MAX;
+    auto touch = [&](size_t offset, size_t length) {
+        for (size_t page = offset / scanPageBytes; page <= (offset + length - 1) / scanPageBytes; page++)
+        {
+            if (lastPage == SIZE_MAX || page > lastPage)
+            {
+                scan.bytesRead += scanPageBytes;
+                lastPage = page;
+            }
+        }
+    };
+    auto bigEndian32 = [&](size_t offset) {
+        return (uint32_t)data[offset] << 24 | (uint32_t)data[offset + 1] << 16 | (uint32_t)data[offset + 2] << 8 | data[offset + 3];
+    };
+
+    while (position + 10 <= end && memcmp(data + position, "ID3", 3) == 0)
+    {
+        touch(position, 10);
+        size_t tagBytes = (size_t)(data[position + 6] & 0x7F) << 21 | (data[position + 7] & 0x7F) << 14
+            | (data[position + 8] & 0x7F) << 7 | (data[position + 9] & 0x7F);
+        position += 10 + tagBytes + ((data[position + 5] & 0x10) ? 10 : 0); // synchsafe size, then the footer
+    }
+    bool id3v1 = end >= 128 && memcmp(data + end - 128, "TAG", 3) == 0;
+    if (id3v1) end -= 128;
+
+    // the first frame is a header followed by another one of the same stream (or by the end of the file)
+    Mp3Frame first, next;
+    for (; position + 4 <= end; position++)
+    {
+        touch(position, 4);
+        if (!parseMp3Frame(data + position, first)) continue;
+        size_t following = position + first.bytes;
+        if (following + 4 > end) break;
+        touch(following, 4);
+        if (parseMp3Frame(data + following, next) && next.sampleRate == first.sampleRate && next.layer == first.layer) break;
+    }
+    if (position + 4 > end) return scan;
+
+    // Xing/Info after the side information of the first frame, VBRI at a fixed place
+    size_t sideInfo = first.version == 1 ? (first.mono ? 17 : 32) : (first.mono ? 9 : 17);
+    size_t xing = position + 4 + sideInfo, vbri = position + 4 + 32;
+    long long frames = 0;
+    touch(position, min(vbri + 18, end) - position);
+    bool xingHeader = xing + 8 <= end && (memcmp(data + xing, "Xing", 4) == 0 || memcmp(data + xing, "Info", 4) == 0);
+    bool vbriHeader = vbri + 18 <= end && memcmp(data + vbri, "VBRI", 4) == 0;
+    if (xingHeader && xing + 12 <= end && (data[xing + 7] & 1))
+    {
+        frames = bigEndian32(xing + 8); // the frames flag is set, the count follows the flags
+        scan.source = DurationSource::XingHeader;
+    }
+    else if (vbriHeader)
+    {
+        frames = bigEndian32(vbri + 14);
+        scan.source = DurationSource::VbriHeader;
+    }
+    if (xingHeader || vbriHeader) position += first.bytes; // the header frame holds no audio
+    if (frames > 0)
+    {
+        scan.milliseconds = frames * first.samples * 1000 / first.sampleRate;
+    }
+    else
+    {
+        long long samples = 0;
+        Mp3Frame frame;
+        while (position + 4 <= end)
+        {
+            touch(position, 4);
+            if (parseMp3Frame(data + position, frame) && frame.sampleRate == first.sampleRate && position + frame.bytes <= end)
+            {
+                samples += frame.samples;
+                position += frame.bytes;
+            }
+            else
+            {
+                position++;
+            }
+        }
+        scan.milliseconds = samples * 1000 / first.sampleRate;
+        scan.source = DurationSource::FrameWalk;
+    }
+    if (id3v1) touch(end, 128);
+    if (!file.buffer.empty()) scan.bytesRead = file.size; // no mapping, it was read whole
+    return scan;
+}
+
+// natural order of file names: runs of digits compare as numbers, so 2.mp3 comes before 10.mp3
+bool naturalLess(const string& a, const string& b)
+{
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size())
+    {
+        if (isdigit((unsigned char)a[i]) && isdigit((unsigned char)b[j]))
+        {
+            size_t endA = i, endB = j;
+            while (endA < a.size() && a[endA] == '0') endA++; // leading zeros do not count
+            while (endB < b.size() && b[endB] == '0') endB++;
+            size_t digitsA = endA, digitsB = endB;
+            while (digitsA < a.size() && isdigit((unsigned char)a[digitsA])) digitsA++;
+            while (digitsB < b.size() && isdigit((unsigned char)b[digitsB])) digitsB++;
+            if (digitsA - endA != digitsB - endB) return digitsA - endA < digitsB - endB;
+            int order = a.compare(endA, digitsA - endA, b, endB, digitsB - endB);
+            if (order != 0) return order < 0;
+            i = digitsA;
+            j = digitsB;
+        }
+        else
+        {
+            if (a[i] != b[j]) return a[i] < b[j];
+            i++;
+            j++;
+        }
+    }
+    return a.size() - i < b.size() - j || (a.size() - i == b.size() - j && a < b);
+}
+
+//builds the catalog from the MP3 files of INPUT/Audios instead of AudiosInfo.txt, in natural name order
+//(the order of the AudiosInfo.txt files of the samples). the files are scanned on options.scanThreads threads,
+//durations are whole seconds unless --precision=ms. also sets durationScale
+//TIME COMPLEXITY: θ(n log n) for the names + the scans of the files, spread over the threads
+bool scanCatalog(const string& testNo)
+{
+    PhaseTimer timer(Phase::Parse);
+    auto start = chrono::high_resolution_clock::now();
+    string directory = "../Sample Tests/Sample " + testNo + "/INPUT/Audios/";
+    vector<string> names;
+    error_code error;
+    for (fs::directory_iterator entry(directory, error), end; !error && entry != end; entry.increment(error))
+    {
+        string extension = entry->path().extension().string();
+        transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+        if (extension == ".mp3" && entry->is_regular_file(error)) names.push_back(entry->path().filename().string());
+    }
+    if (error || names.empty())
+    {
+        cerr << "Error: no MP3 file to scan in " << directory << endl;
+        return false;
+    }
+    sort(names.begin(), names.end(), naturalLess); //O(n log n)
+
+    vector<AudioScan> scans(names.size());
+    int threads = options.scanThreads > 0 ? options.scanThreads : max(1u, thread::hardware_concurrency());
+    threads = min<int>(threads, names.size());
+    atomic<size_t> nextFile{ 0 };
+    auto scanFiles = [&] {
+        for (size_t i = nextFile++; i < names.size(); i = nextFile++) scans[i] = scanMp3(directory + names[i]);
+    };
+    vector<thread> workers;
+    for (int t = 1; t < threads; t++) workers.emplace_back(scanFiles);
+    scanFiles();
+    for (thread& worker : workers) worker.join();
+
+    catalog.names.clear();
+    catalog.nameOffsets.assign(1, 0);
+    catalog.nameOffsets.reserve(names.size() + 1);
+    catalog.durations.clear();
+    catalog.durations.reserve(names.size());
+    durationScale = (options.precision == DurationPrecision::Milliseconds) ? 1000 : 1;
+    long long bytesRead = 0, bytesOnDisk = 0, bySource[3] = {};
+    for (size_t i = 0; i < names.size(); i++) //θ(n)
+    {
+        const AudioScan& scan = scans[i];
+        if (scan.source == DurationSource::Failed || scan.milliseconds >= INT32_MAX)
+        {
+            cerr << "Error: " << directory << names[i] << (scan.source == DurationSource::Failed
+                ? " has no MPEG audio frame." : " is longer than 596 hours.") << endl;
+            return false;
+        }
+        catalog.names += names[i];
+        catalog.nameOffsets.push_back(catalog.names.size());
+        catalog.durations.push_back((int32_t)toDurationUnits(scan.milliseconds));
+        bytesRead += scan.bytesRead;
+        bytesOnDisk += fs::file_size(directory + names[i], error);
+        bySource[(int)scan.source]++;
+    }
+    catalogHash = fnv1a(catalog.names.data(), catalog.names.size());
+    catalogHash = fnv1a(catalog.nameOffsets.data(), catalog.nameOffsets.size() * sizeof(uint32_t), catalogHash);
+    catalogHash = fnv1a(catalog.durations.data(), catalog.durations.size() * sizeof(int32_t), catalogHash);
+    count(Counter::BytesScanned, bytesRead);
+
+    double milliseconds = millisecondsSince(start);
+    cout << "Scanned " << names.size() << " MP3 files on " << threads << (threads == 1 ? " thread" : " threads") << " in "
+        << milliseconds << " ms: " << (long long)(names.size() * 1000 / max(milliseconds, 1e-3)) << " files/s, "
+        << bytesRead / (long long)names.size() << " bytes read per file (of " << bytesOnDisk / (long long)names.size() << ")" << endl;
+    cout << "Durations from " << bySource[0] << " " << durationSourceNames[0] << ", " << bySource[1] << " " << durationSourceNames[1]
+        << ", " << bySource[2] << " " << durationSourceNames[2] << endl;
+    return true;
+}
+
+
+
+//########################### PACKING PLANS ###################################
+
+//reads AudiosInfo.txt of the test into the catalog: the file is mapped in memory and parsed in place,
+//a count line then one "name HH:MM:SS" (or HH:MM:SS.mmm) line per file, this also sets durationScale
+//TIME COMPLEXITY: θ(size of AudiosInfo.txt)
+bool readCatalog(const string& testNo)
+{
+    PhaseTimer timer(Phase::Parse);
+    string path = "../Sample Tests/Sample " + testNo + "/INPUT/AudiosInfo.txt";
+    MappedFile input;
+    if (!input.open(path)) 
+    {
+        cerr << "Error: Could not open AudiosInfo.txt file." << endl;
+        return false;
+    }
+
+    catalogHash = fnv1a(input.data, input.size);
+    const char* p = input.data;
+    const char* end = input.data + input.size;
+    auto isSpace = [](char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; };
+    auto skipSpaces = [&] { while (p < end && isSpace(*p)) p++; };
+
+    int numberOfFiles;
+    skipSpaces();
+    if (!parseNumber(p, end, numberOfFiles))
+    {
+        cerr << "Error: AudiosInfo.txt does not start with the number of files." << endl;
+        return false;
+    }
+
+    catalog.names.clear();
+    catalog.names.reserve(input.size); // names are shorter than the file, the arena never grows
+    catalog.nameOffsets.assign(1, 0);
+    catalog.nameOffsets.reserve(numberOfFiles + 1);
+    catalog.durations.clear();
+    catalog.durations.reserve(numberOfFiles);
+    vector<long long> milliseconds;
+    milliseconds.reserve(numberOfFiles);
+
+    //reads file names and converts durations to seconds
+    for (int i = 0; i < numberOfFiles; ++i) //θ(n)
+    {
+        skipSpaces();
+        const char* name = p;
+        while (p < end && !isSpace(*p)) p++;
+        size_t nameLength = p - name;
+        skipSpaces();
+
+        long long duration;
+        if (nameLength == 0 || !parseDuration(p, end, duration) || duration >= INT32_MAX || catalog.names.size() + nameLength > UINT32_MAX)
+        {
+            cerr << "Error: AudiosInfo.txt entry " << i + 1 << " is not \"name HH:MM:SS[.mmm]\" (up to 596 hours)." << endl;
+            return false;
+        }
+        catalog.names.append(name, nameLength);
+        catalog.nameOffsets.push_back(catalog.names.size());
+        milliseconds.push_back(duration);
+    }
+
+    // whole seconds unless a duration has milliseconds (or --precision says otherwise)
+    bool subSecond = any_of(milliseconds.begin(), milliseconds.end(), [](long long duration) { return duration % 1000 != 0; });
+    durationScale = (options.precision == DurationPrecision::Milliseconds
+        || (options.precision == DurationPrecision::Auto && subSecond)) ? 1000 : 1;
+    for (long long duration : milliseconds) //θ(n)
+    {
+        catalog.durations.push_back((int32_t)toDurationUnits(duration));
+    }
+    return true;
+}
+
+//the catalog of the test: scanned from its MP3 files with --scan or when it has no AudiosInfo.txt, read otherwise
+bool loadCatalog(const string& testNo)
+{
+    bool listed = fs::exists("../Sample Tests/Sample " + testNo + "/INPUT/AudiosInfo.txt");
+    return (options.scan || !listed) ? scanCatalog(testNo) : readCatalog(testNo);
+}
+
+//reads the header of a packing plan: the test and the algorithm (folder name) it was made for
+bool readPlanHeader(istream& plan, string& testNo, string& folderName)
+{
+    string magic, version, key;
+    plan >> magic >> version >> key >> testNo;
+    bool validHeader = (magic == "sound-packing-plan" && key == "test");
+    plan >> key;
+    getline(plan, folderName);
+    if (!plan || !validHeader || key != "algorithm" || folderName.size() < 2)
+    {
+        return false;
+    }
+    folderName = folderName.substr(1); // space after "algorithm"
+    return true;
+}
+
+//writes the folders of the rest of a plan (after its header) as the algorithm would have, one folder at a time.
+//returns the folder count, -1 when the plan does not match the catalog
+//TIME COMPLEXITY: O(n) + FOLDER PROCESSING where n is the number of files in the plan
+int replayPlan(istream& plan, const FileList& files, const string& folderName, const string& testNo, IOBatch& batch)
+{
+    vector<int> chosenFilesIndexes;
+    int currentFolder = -1, folderId, fileIndex, duration, folderCount = 0;
+    while (plan >> folderId >> fileIndex >> duration) //O(n)
+    {
+        if (fileIndex < 0 || fileIndex >= files.size() || files.durations[fileIndex] != duration)
+        {
+            cerr << "\nError: plan entry " << folderId << " " << fileIndex << " " << duration
+                << " does not match AudiosInfo.txt of Sample " << testNo << "." << endl;
+            ioPipeline.finishBatch(batch);
+            return -1;
+        }
+        if (folderId != currentFolder && !chosenFilesIndexes.empty())
+        {
+            processFiles(files, currentFolder, chosenFilesIndexes, folderName, testNo, batch);
+            chosenFilesIndexes.clear();
+            folderCount++;
+        }
+        currentFolder = folderId;
+        chosenFilesIndexes.push_back(fileIndex);
+    }
+    if (!chosenFilesIndexes.empty())
+    {
+        processFiles(files, currentFolder, chosenFilesIndexes, folderName, testNo, batch);
+        folderCount++;
+    }
+
+    ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+    return folderCount;
+}
+
+//builds the folders of a manifest written in plan-only mode, it can run later or on another machine
+//with the same Sample Tests layout. the manifest is streamed, only one folder is held at a time
+//TIME COMPLEXITY: O(n) + FOLDER PROCESSING where n is the number of files in the plan
+bool applyPlan(const string& planPath)
+{
+    ifstream plan(planPath);
+    string testNo, folderName;
+    if (!readPlanHeader(plan, testNo, folderName))
+    {
+        cerr << "Error: " << planPath << " is not a packing plan." << endl;
+        return false;
+    }
+
+    if (!loadCatalog(testNo))
+    {
+        return false;
+    }
+    FileList files = catalog.files();
+    MetricsScope scope(metricsRegistry.add(folderName));
+
+    fs::create_directories("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName);
+
+    cout << "\nApplying " << planPath << " (" << folderName << "):\n";
+
+    IOBatch batch;
+    int folderCount = replayPlan(plan, files, folderName, testNo, batch);
+    if (folderCount < 0)
+    {
+        return false;
+    }
+    cout << "\nFolder Count: " << folderCount << endl;
+    return true;
+}
+
+//bumped whenever the plan format or the packing of an engine changes, entries of older versions then miss
+const uint32_t planCacheVersion = 3;
+
+//content addressed plans of earlier runs: CACHE/<key>.plan next to INPUT and OUTPUT, where the key hashes
+//the catalog, the capacity, the algorithm and the options its packing depends on. an algorithm whose
+//key is there replays the plan instead of packing, its folders are then synced like any other run
+struct PlanCache {
+    string directory;       // empty when the cache is off
+    string testNo;
+    int folderCapacity = 0;
+
+    void open(const string& test, int capacity)
+    {
+        if (!options.planCache) return;
+        testNo = test;
+        folderCapacity = capacity;
+        directory = "../Sample Tests/Sample " + testNo + "/CACHE/";
+        fs::create_directories(directory);
+    }
+
+    // entry of an algorithm for the current catalog and options, empty when the cache is off
+    string path(const string& algorithmId) const
+    {
+        if (directory.empty()) return "";
+        uint64_t key = fnv1a(algorithmId.data(), algorithmId.size(), catalogHash);
+        auto mix = [&key](const auto& value) { key = fnv1a(&value, sizeof(value), key); };
+        mix(planCacheVersion);
+        mix(folderCapacity);
+        mix(durationScale);
+        mix(options.dpEngine);
+        mix(options.dpStates);
+        mix(options.epsilon);
+        mix(options.shards);
+        mix(options.repairBelow);
+        ostringstream name;
+        name << hex << setw(16) << setfill('0') << key << ".plan";
+        return directory + name.str();
+    }
+
+    // keeps the entries used most recently (a hit touches its entry)
+    void prune(size_t keep)
+    {
+        if (directory.empty()) return;
+        error_code error;
+        vector<pair<fs::file_time_type, fs::path>> entries;
+        for (const fs::directory_entry& entry : fs::directory_iterator(directory, error))
+        {
+            entries.push_back({ entry.last_write_time(error), entry.path() });
+        }
+        if (entries.size() <= keep) return;
+        sort(entries.begin(), entries.end(), greater<pair<fs::file_time_type, fs::path>>());
+        for (size_t i = keep; i < entries.size(); i++)
+        {
+            fs::remove(entries[i].second, error);
+        }
+    }
+};
+PlanCache planCache;
+
+//replays a cached plan instead of running the algorithm, false when the entry cannot be used
+//TIME COMPLEXITY: O(n) + FOLDER PROCESSING
+bool replayCachedPlan(const string& planPath, AlgorithmReport& report)
+{
+    ifstream plan(planPath);
+    string testNo;
+    if (!readPlanHeader(plan, testNo, report.name) || testNo != planCache.testNo)
+    {
+        return false;
+    }
+    console() << "Cached plan " << fs::path(planPath).filename().string() << ", packing skipped\n";
+
+    FileList files = catalog.files();
+    fs::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + report.name);
+    IOBatch batch;
+    report.folderCount = replayPlan(plan, files, report.name, testNo, batch);
+    report.ioMilliseconds = batch.milliseconds;
+    if (report.folderCount < 0)
+    {
+        return false;
+    }
+
+    error_code error;
+    fs::last_write_time(planPath, fs::file_time_type::clock::now(), error);
+    console() << "\nFolder Count: " << report.folderCount << endl;
+    return true;
+}
+
+//removes everything in OUTPUT the run did not write (algorithms not run or skipped, manifests of an older
+//plan-only run...), so OUTPUT holds the same entries as if it had been emptied first
+void removeOtherOutput(const string& testNo, const vector<AlgorithmReport>& reports)
+{
+    unordered_set<string> written;
+    for (const AlgorithmReport& report : reports)
+    {
+        if (!report.stopped.empty()) continue;
+        written.insert(report.name);
+        if (options.planOnly) written.insert(report.name + ".plan");
+    }
+    error_code error;
+    for (const fs::directory_entry& entry : fs::directory_iterator("../Sample Tests/Sample " + testNo + "/OUTPUT", error))
+    {
+        if (!written.count(entry.path().filename().string()))
+            fs::remove_all(entry.path(), error);
+    }
+}
+
+
+
+//########################### STREAMING MODE ###################################
+
+// per-file placement latency as a log-linear histogram: exact below 8 ns, then 8 buckets per power of two,
+// so a percentile is within 12.5% of the real one whatever the number of samples, in constant memory
+struct LatencyHistogram {
+    static const int subBuckets = 8;
+    long long counts[64 * subBuckets] = {};
+    long long samples = 0;
+    long long maxNanoseconds = 0;
+
+    static int bucketOf(long long nanoseconds) //O(1)
+    {
+        if (nanoseconds < subBuckets) return (int)max(0LL, nanoseconds);
+        int exponent = highestBit(nanoseconds); // >= 3
+        int sub = (int)(nanoseconds >> (exponent - 3)) - subBuckets;
+        return subBuckets + (exponent - 3) * subBuckets + sub;
+    }
+
+    // highest value that falls into a bucket
+    static long long upperEdge(int bucket) //O(1)
+    {
+        if (bucket < subBuckets) return bucket;
+        int exponent = (bucket - subBuckets) / subBuckets + 3;
+        int sub = (bucket - subBuckets) % subBuckets;
+        return ((long long)(subBuckets + sub + 1) << (exponent - 3)) - 1;
+    }
+
+    void add(long long nanoseconds) //O(1)
+    {
+        counts[bucketOf(nanoseconds)]++;
+        samples++;
+        maxNanoseconds = max(maxNanoseconds, nanoseconds);
+    }
+
+    // nearest rank percentile, q in (0, 1]
+    long long percentile(double q) const //O(buckets)
+    {
+        long long rank = (long long)(q * samples), seen = 0;
+        if (rank < q * samples || rank == 0) rank++;
+        for (int bucket = 0; bucket < 64 * subBuckets; bucket++)
+        {
+            seen += counts[bucket];
+            if (seen >= rank) return min(upperEdge(bucket), maxNanoseconds);
+        }
+        return maxNanoseconds;
+    }
+};
+
+// a folder still taking files in streaming mode
+struct OpenFolder {
+    vector<pair<string, int>> files;
+    int remainingCapacity = 0;
+    chrono::steady_clock::time_point opened;
+    long long serial = -1;      // which opening of this slot, -1 while the slot is free
+};
+
+// online Worst-Fit (or Best-Fit): every file goes to the open folder with the most room left
+// (or the tightest one it fits) through a CapacityIndex, O(log64 C) per file.
+// a folder is closed and handed to the I/O pipeline as soon as it is full enough, once it is older than
+// the age limit, or when it is the fullest one and a new folder would go over the open folder limit.
+// only the open folders are held, so memory is bounded by maxOpen folders whatever the length of the stream
+struct StreamPacker {
+    int capacity;
+    bool bestFit;
+    int closeRemaining;             // a folder with this much room left or less is closed
+    chrono::seconds maxAge;         // 0 for no age limit
+    int maxOpen;
+    string folderName, testNo;
+    IOBatch& batch;
+
+    vector<OpenFolder> slots;
+    vector<int> freeSlots;
+    CapacityIndex index;                    // open folders by remaining capacity
+    deque<pair<long long, int>> byAge;      // (serial, slot) in opening order, closed ones are dropped lazily
+    long long nextSerial = 0;
+    int openFolders = 0, peakOpenFolders = 0, closedFolders = 0;
+    long long files = 0, closedFull = 0, closedByAge = 0, closedByLimit = 0, closedAtEnd = 0;
+
+    StreamPacker(int capacity, bool bestFit, int closeAtPercent, int maxAgeSeconds, int maxOpen,
+        const string& folderName, const string& testNo, IOBatch& batch)
+        : capacity(capacity), bestFit(bestFit), closeRemaining(capacity - (int)((long long)capacity * closeAtPercent / 100)),
+        maxAge(maxAgeSeconds), maxOpen(maxOpen), folderName(folderName), testNo(testNo), batch(batch), index(capacity)
+    {
+    }
+
+    // writes the folder out and frees its slot, it must not be in the index anymore
+    void close(int slot, long long& reason) //O(files in the folder)
+    {
+        OpenFolder& folder = slots[slot];
+        PhaseTimer timer(Phase::Submit);
+        count(Counter::FilesPlaced, folder.files.size());
+        submitFolder(move(folder.files), ++closedFolders, folderName, testNo, batch);
+
+        folder.files.clear();
+        folder.serial = -1;
+        freeSlots.push_back(slot);
+        openFolders--;
+        reason++;
+    }
+
+    int open() //O(log64 C)
+    {
+        if (maxOpen > 0 && openFolders >= maxOpen)
+        {
+            // make room by closing the fullest folder, it is the least likely to take more files
+            close(index.take(index.successor(0)), closedByLimit);
+        }
+        int slot;
+        if (freeSlots.empty())
+        {
+            slot = slots.size();
+            slots.emplace_back();
+        }
+        else
+        {
+            slot = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        OpenFolder& folder = slots[slot];
+        folder.remainingCapacity = capacity;
+        folder.opened = chrono::steady_clock::now();
+        folder.serial = nextSerial++;
+        if (maxAge.count() > 0) byAge.emplace_back(folder.serial, slot);
+        openFolders++;
+        peakOpenFolders = max(peakOpenFolders, openFolders);
+        return slot;
+    }
+
+    // closes every folder past the age limit
+    void closeExpired(chrono::steady_clock::time_point now) //O(expired folders * (log64 C + bucket size))
+    {
+        while (!byAge.empty())
+        {
+            auto [serial, slot] = byAge.front();
+            OpenFolder& folder = slots[slot];
+            if (folder.serial == serial)
+            {
+                if (now - folder.opened < maxAge) break;
+                index.erase(slot, folder.remainingCapacity);
+                close(slot, closedByAge);
+            }
+            byAge.pop_front();
+        }
+    }
+
+    void add(string name, int duration) //O(log64 C)
+    {
+        int slot = -1;
+        if (duration <= capacity)
+        {
+            int remainingCapacity = bestFit ? index.successor(duration) : index.nonEmpty.highest();
+            if (remainingCapacity >= duration) slot = index.take(remainingCapacity);
+        }
+        if (slot == -1) slot = open();
+
+        OpenFolder& folder = slots[slot];
+        folder.files.emplace_back(move(name), duration);
+        folder.remainingCapacity -= duration;
+        files++;
+
+        // an oversized file leaves its folder over capacity, it is closed right away
+        if (folder.remainingCapacity <= closeRemaining)
+            close(slot, closedFull);
+        else
+            index.insert(slot, folder.remainingCapacity);
+    }
+
+    // end of the stream, the open folders are written out oldest first
+    void closeAll() //O(open folders log open folders)
+    {
+        vector<int> openSlots;
+        for (int slot = 0; slot < slots.size(); slot++)
+        {
+            if (slots[slot].serial >= 0) openSlots.push_back(slot);
+        }
+        sort(openSlots.begin(), openSlots.end(), [&](int a, int b) { return slots[a].serial < slots[b].serial; });
+        for (int slot : openSlots)
+        {
+            index.erase(slot, slots[slot].remainingCapacity);
+            close(slot, closedAtEnd);
+        }
+        byAge.clear();
+    }
+};
+
+// streaming mode: packs "name HH:MM:SS" lines from a file or stdin ("-") as they arrive, nothing is sorted
+// and no catalog is read (a count line, as AudiosInfo.txt starts with, is skipped).
+// with --follow=SECONDS the end of the file is not the end of the stream, it waits for the file to grow
+// and only stops once nothing came for that long. the audio files are taken from Sample testNo/INPUT/Audios
+//TIME COMPLEXITY: O(n log64 C) + FOLDER PROCESSING
+bool runStream(const string& streamPath, const string& testNo, int folderCapacity)
+{
+    ifstream streamFile;
+    if (streamPath != "-")
+    {
+        streamFile.open(streamPath);
+        if (!streamFile.is_open())
+        {
+            cerr << "Error: Could not open " << streamPath << endl;
+            return false;
+        }
+    }
+    istream& input = (streamPath == "-") ? cin : streamFile;
+    bool follow = options.streamFollow > 0 && streamPath != "-";
+
+    string folderName = options.streamBestFit ? "[6.1] Streaming BestFit" : "[6.0] Streaming WorstFit";
+    MetricsScope scope(metricsRegistry.add(folderName));
+    string algorithmDirectory = "../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName;
+    fs::create_directories(algorithmDirectory);
+
+    cout << "\nStreaming " << (streamPath == "-" ? string("stdin") : streamPath) << " into " << folderName
+        << " (capacity " << folderCapacity / (double)durationScale << " s, closing at " << options.streamCloseAt << "%, at most "
+        << options.streamMaxOpen << " open folders";
+    if (options.streamMaxAge > 0) cout << ", " << options.streamMaxAge << " s age limit";
+    cout << "):\n";
+
+    IOBatch batch;
+    StreamPacker packer(folderCapacity, options.streamBestFit, options.streamCloseAt, options.streamMaxAge,
+        options.streamMaxOpen, folderName, testNo, batch);
+    LatencyHistogram latency;
+    long long invalidLines = 0;
+    auto streamStart = chrono::high_resolution_clock::now();
+    auto lastData = chrono::steady_clock::now();
+
+    string line, pending;
+    while (true)
+    {
+        if (!getline(input, line))
+        {
+            if (!follow) break;
+
+            // at the end of a growing file: wait for more, closing the folders that get too old meanwhile
+            input.clear();
+            auto now = chrono::steady_clock::now();
+            if (options.streamMaxAge > 0) packer.closeExpired(now);
+            if (now - lastData >= chrono::seconds(options.streamFollow)) break;
+            this_thread::sleep_for(chrono::milliseconds(50));
+            continue;
+        }
+        if (follow && input.eof())
+        {
+            // the last line has no end yet, the writer may still be on it
+            pending += line;
+            input.clear();
+            continue;
+        }
+        line = pending + line;
+        pending.clear();
+        lastData = chrono::steady_clock::now();
+
+        PhaseTimer placeTimer(Phase::Pack);
+        const char* p = line.data();
+        const char* end = p + line.size();
+        while (end > p && (end[-1] == '\r' || end[-1] == ' ' || end[-1] == '\t')) end--;
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+        if (p == end) continue; // empty line
+
+        const char* name = p;
+        while (p < end && *p != ' ' && *p != '\t') p++;
+        string fileName(name, p);
+        while (p < end && (*p == ' ' || *p == '\t')) p++;
+
+        long long duration;
+        if (p == end && fileName.find_first_not_of("0123456789") == string::npos)
+        {
+            continue; // count line
+        }
+        if (!parseDuration(p, end, duration) || p != end || toDurationUnits(duration) >= INT32_MAX)
+        {
+            cerr << "Warning: skipping \"" << line << "\", it is not \"name HH:MM:SS[.mmm]\"." << endl;
+            invalidLines++;
+            continue;
+        }
+
+        if (options.streamMaxAge > 0) packer.closeExpired(lastData);
+        packer.add(move(fileName), (int)toDurationUnits(duration)); //O(log64 C)
+        latency.add(placeTimer.stop());
+    }
+    packer.closeAll();
+    double streamMilliseconds = millisecondsSince(streamStart);
+
+    ioPipeline.finishBatch(batch); // Progress bar while the last folders are written
+    cout << "\nFolder Count: " << packer.closedFolders << " for " << packer.files << " files";
+    if (invalidLines > 0) cout << " (" << invalidLines << " invalid lines skipped)";
+    cout << endl;
+    cout << "Closed when full enough: " << packer.closedFull << ", too old: " << packer.closedByAge
+        << ", over the open folder limit: " << packer.closedByLimit << ", at the end of the stream: " << packer.closedAtEnd << endl;
+    cout << "Peak open folders: " << packer.peakOpenFolders << endl;
+    cout << "Placement latency: p50 " << latency.percentile(0.5) / 1e3 << " us, p99 " << latency.percentile(0.99) / 1e3
+        << " us, max " << latency.maxNanoseconds / 1e3 << " us (" << packer.files / max(streamMilliseconds / 1000, 1e-9)
+        << " files/s over " << streamMilliseconds << " ms)" << endl;
+    return true;
+}
+
+
+
+//########################### SHARDED PACKING ###################################
+
+// an engine that hands its folders back as indexes into files
+using PackingEngine = function<void(int folderCapacity, const vector<int>& durations, FolderTable& folders)>;
+
+// an engine sharded mode can run, decreasing ones take the sorted catalog
+struct ShardableEngine {
+    string id;
+    string folderName;
+    bool decreasing;
+    PackingEngine pack;
+};
+
+// the engines of the sharded mode, the sweep and the server. the worst-fit tasks 1, 1.1, 2 and 2.1 are left out:
+// the bucket queue engines 1.2 and 2.2 give the same folder counts and place every file faster
+vector<ShardableEngine> shardableEngines()
+{
+    auto folderFillingEngine = [](int folderCapacity, const vector<int>& durations, FolderTable& folders) {
+        folderFillingDP(folderCapacity, durations, folders);
+    };
+    auto durationClassesEngine = [](int folderCapacity, const vector<int>& durations, FolderTable& folders) {
+        folderFillingDurationClasses(folderCapacity, durations, folders);
+    };
+
+    return {
+        { "1.2", "[1.2] WorstFit Bucket Queue", false, folderFillingWFBuckets },
+        { "2.2", "[2.2] WorstFit Decreasing Bucket Queue", true, folderFillingWFBuckets },
+        { "3", "[3] FirstFit Decreasing", true, folderFillingFFD },
+        { "3.1", "[3.1] FirstFit Decreasing Tree", true, folderFillingFFDTree },
+        { "4", "[4] FolderFilling", false, folderFillingEngine },
+        { "4.1", "[4.1] FolderFilling Duration Classes", false, durationClassesEngine },
+        { "5", "[5.0] BestFit", false, folderFillingBFD },
+        { "5.1", "[5.1] BestFit Decreasing", true, folderFillingBFD },
+    };
+}
+
+// what a sharded run produced
+struct ShardedPacking {
+    FolderTable folders{ &resultArena };    // into the full file list
+    int shardFolders = 0;                   // folders out of the shards, before the repair
+    int repairedFiles = 0;                  // files of the underfilled folders packed again
+    int repairedFoldersBefore = 0, repairedFoldersAfter = 0;
+    double packMilliseconds = 0;            // the shards, on every thread
+    double repairMilliseconds = 0;
+};
+
+// sharded packing: file i goes to shard i % shards, so on the sorted catalog every shard gets the same
+// mix of long and short files, and the shards are packed on "threads" threads with the same engine.
+// then the tail repair: the underfilled folders (below repairBelow percent of the capacity) of every shard
+// are packed again together, they are kept as they were if that does not save a folder.
+// the result only depends on the number of shards, not on the number of threads
+//TIME COMPLEXITY: the engine over shards of n/shards files, shards/threads of them at a time
+//+ the engine over the files of the underfilled folders
+ShardedPacking packSharded(const PackingEngine& engine, int folderCapacity, const vector<int>& durations,
+    int shards, int threads, int repairBelow)
+{
+    ShardedPacking result;
+    shards = max(1, min<int>(shards, durations.size()));
+    threads = max(1, min(threads, shards));
+
+    auto packStart = chrono::high_resolution_clock::now();
+    vector<FolderTable> shardFolders(shards);   // filled on the workers, so on the default resource and not the arena
+    vector<exception_ptr> errors(shards);
+    atomic<int> nextShard{ 0 };
+    Metrics& scope = metrics();
+    auto packShards = [&] {
+        MetricsScope threadScope(scope);
+        for (int shard = nextShard++; shard < shards; shard = nextShard++)
+        {
+            try
+            {
+                vector<int> shardDurations;
+                shardDurations.reserve(durations.size() / shards + 1);
+                for (size_t i = shard; i < durations.size(); i += shards) shardDurations.push_back(durations[i]); //θ(n / shards)
+                engine(folderCapacity, shardDurations, shardFolders[shard]);
+                for (int& fileIndex : shardFolders[shard].keys) fileIndex = fileIndex * shards + shard; // back to the full list
+            }
+            catch (...)
+            {
+                errors[shard] = current_exception();
+            }
+        }
+    };
+    vector<thread> workers;
+    for (int t = 1; t < threads; t++) workers.emplace_back(packShards);
+    packShards();
+    for (thread& worker : workers) worker.join();
+    for (exception_ptr& error : errors)
+    {
+        if (error) rethrow_exception(error);
+    }
+    result.packMilliseconds = millisecondsSince(packStart);
+
+    // tail repair
+    auto repairStart = chrono::high_resolution_clock::now();
+    vector<FileSpan> underfilled;
+    for (const FolderTable& folders : shardFolders) result.shardFolders += folders.size();
+    result.folders.reserve(result.shardFolders, durations.size());
+    for (const FolderTable& folders : shardFolders) //θ(n)
+    {
+        for (size_t f = 0; f < folders.size(); f++)
+        {
+            FileSpan folder = folders[f];
+            long long duration = 0;
+            for (int fileIndex : folder) duration += durations[fileIndex];
+            if (duration * 100 < (long long)folderCapacity * repairBelow)
+                underfilled.push_back(folder);
+            else
+                result.folders.appendFolder(folder.begin(), folder.end());
+        }
+    }
+
+    // the files of the underfilled folders in the order of the full list (still sorted when it was)
+    vector<int> repairIndexes;
+    for (FileSpan folder : underfilled) repairIndexes.insert(repairIndexes.end(), folder.begin(), folder.end());
+    sort(repairIndexes.begin(), repairIndexes.end()); //O(r log r)
+    vector<int> repairDurations;
+    for (int fileIndex : repairIndexes) repairDurations.push_back(durations[fileIndex]);
+
+    FolderTable repaired(&resultArena);
+    engine(folderCapacity, repairDurations, repaired);
+    result.repairedFiles = repairIndexes.size();
+    result.repairedFoldersBefore = underfilled.size();
+    result.repairedFoldersAfter = min(repaired.size(), underfilled.size());
+    if (repaired.size() < underfilled.size())
+    {
+        for (size_t f = 0; f < repaired.size(); f++)
+        {
+            for (int fileIndex : repaired[f]) result.folders.push_back(repairIndexes[fileIndex]);
+            result.folders.closeFolder();
+        }
+    }
+    else
+    {
+        for (FileSpan folder : underfilled) result.folders.appendFolder(folder.begin(), folder.end());
+    }
+    result.repairMilliseconds = millisecondsSince(repairStart);
+    return result;
+}
+
+// sharded caller: packs with 1, 2, 4 ... up to options.shards threads to report the speedup, compares the
+// folder count with the unsharded engine (unless --skip-unsharded) and writes the sharded folders
+// TIME COMPLEXITY: FOLDER PROCESSING + packSharded for every thread count + the engine over all the files
+AlgorithmReport shardedCaller(const ShardableEngine& engine, int folderCapacity, const FileList& files,
+    const LowerBounds& bounds, string testNo)
+{
+    string folderName = engine.folderName + " Sharded";
+    if (engine.id == "4.1" && durationScale != 1)
+    {
+        console() << "Skipped: duration classes work per second, use 4 with --dp=sparse at millisecond precision" << endl;
+        AlgorithmReport report{ folderName };
+        report.stopped = "skipped";
+        return report;
+    }
+    filesystem::create_directory("../Sample Tests/Sample " + testNo + "/OUTPUT/" + folderName);
+    IOBatch batch;
+
+    int unshardedFolders = -1;
+    double unshardedMilliseconds = 0;
+    if (!options.skipUnsharded)
+    {
+        PhaseTimer packTimer(Phase::Pack);
+        FolderTable folders(&resultArena);
+        engine.pack(folderCapacity, files.durations, folders);
+        unshardedMilliseconds = packTimer.stop() / 1e6;
+        unshardedFolders = folders.size();
+    }
+
+    console() << "\n" << options.shards << " shards, folders below " << options.repairBelow << "% packed again:\n";
+    console() << fixed << setprecision(2);
+    console() << setw(10) << "Threads" << setw(14) << "Pack ms" << setw(14) << "Repair ms" << setw(10) << "Speedup";
+    if (unshardedFolders >= 0) console() << setw(16) << "vs unsharded";
+    console() << "\n";
+
+    ShardedPacking result;
+    double oneThreadMilliseconds = 0;
+    for (int threads = 1; ; threads = min(threads * 2, options.shards))
+    {
+        PhaseTimer packTimer(Phase::Pack);
+        result = packSharded(engine.pack, folderCapacity, files.durations, options.shards, threads, options.repairBelow);
+        double milliseconds = packTimer.stop() / 1e6;
+        if (threads == 1) oneThreadMilliseconds = milliseconds;
+
+        console() << setw(10) << threads << setw(14) << result.packMilliseconds << setw(14) << result.repairMilliseconds
+            << setw(9) << oneThreadMilliseconds / max(milliseconds, 1e-9) << "x";
+        if (unshardedFolders >= 0) console() << setw(15) << unshardedMilliseconds / max(milliseconds, 1e-9) << "x";
+        console() << "\n";
+        if (threads >= options.shards) break;
+    }
+    console().unsetf(ios::floatfield);
+    console() << setprecision(6);
+
+    int folderCount = result.folders.size();
+    for (int folderIndex = 0; folderIndex < folderCount; ++folderIndex)
+    {
+        processFiles(files, folderIndex + 1, result.folders[folderIndex], folderName, testNo, batch);
+    }
+    ioPipeline.finishBatch(batch); // Progress bar while the folders are written
+
+    console() << "\nFolder Count: " << folderCount << " (" << result.shardFolders << " out of the shards, "
+        << result.repairedFoldersBefore << " underfilled folders with " << result.repairedFiles << " files repacked into "
+        << result.repairedFoldersAfter << ")" << endl;
+    if (unshardedFolders >= 0)
+    {
+        console() << "Unsharded: " << unshardedFolders << " folders in " << unshardedMilliseconds << " ms, gap "
+            << (folderCount >= unshardedFolders ? "+" : "") << folderCount - unshardedFolders << " folders" << endl;
+    }
+    console() << "Lower bound: " << bounds.best() << " folders" << endl;
+    return { folderName, folderCount, result.packMilliseconds + result.repairMilliseconds, batch.milliseconds };
+}
+
+
+
+//########################### CAPACITY SWEEP ###################################
+
+// --sweep items in the current units: "SECONDS[.mmm]" or a range "FROM-TO:STEP" (TO included),
+// sorted without duplicates. false when an item is neither or a range has more than 10000 capacities
+bool parseSweep(const vector<string>& items, vector<int>& capacities)
+{
+    capacities.clear();
+    for (const string& item : items)
+    {
+        size_t dash = item.find('-'), colon = item.find(':');
+        if (dash == string::npos && colon == string::npos)
+        {
+            int capacity;
+            if (!parseCapacity(item, capacity) || capacity <= 0) return false;
+            capacities.push_back(capacity);
+            continue;
+        }
+        int from, to, step;
+        if (dash == string::npos || colon == string::npos || colon < dash
+            || !parseCapacity(item.substr(0, dash), from) || !parseCapacity(item.substr(dash + 1, colon - dash - 1), to)
+            || !parseCapacity(item.substr(colon + 1), step) || from <= 0 || step <= 0 || to < from || (to - from) / step >= 10000)
+        {
+            return false;
+        }
+        for (long long capacity = from; capacity <= to; capacity += step) capacities.push_back((int)capacity);
+    }
+    sort(capacities.begin(), capacities.end());
+    capacities.erase(unique(capacities.begin(), capacities.end()), capacities.end());
+    return !capacities.empty();
+}
+
+// one engine at one capacity of the sweep
+struct SweepCell {
+    int folderCount = -1;           // -1 when the engine was skipped
+    double packMilliseconds = 0;
+};
+
+//capacity sweep: the engines of shardableEngines (or the ones of --algorithms) at every capacity, from one read
+//and one sort of the catalog, the engines themselves pack every capacity on its own.
+//only the folders of chosenCapacity (--capacity, 0 for none) are written, like a normal run would
+//TIME COMPLEXITY: O(n log n) once + the engines at every capacity
+bool runSweep(const string& testNo, vector<int> capacities, int chosenCapacity)
+{
+    vector<ShardableEngine> engines = shardableEngines();
+    if (!options.algorithms.empty())
+    {
+        vector<ShardableEngine> selected;
+        for (const string& id : options.algorithms)
+        {
+            auto engine = find_if(engines.begin(), engines.end(), [&](const ShardableEngine& e) { return e.id == id; });
+            if (engine == engines.end())
+            {
+                cerr << "Error: --sweep packs with 1.2, 2.2, 3, 3.1, 4, 4.1, 5 and 5.1, not " << id << endl;
+                return false;
+            }
+            selected.push_back(*engine);
+        }
+        engines = selected;
+    }
+    if (durationScale != 1 && !options.dpEngineChosen)
+    {
+        options.dpEngine = DPEngine::Sparse; // the default of a normal run, a table column per millisecond would not fit
+    }
+
+    PhaseTimer sortTimer(Phase::Sort);
+    vector<int> decreasingOrder = catalog.decreasingOrder(); //O(nlogn)
+    double sortMilliseconds = sortTimer.stop() / 1e6;
+    FileList files = catalog.files();
+    FileList sortedFiles = catalog.files(move(decreasingOrder));
+
+    // a capacity below the longest file cannot be packed: it is left out of the sweep
+    int longest = sortedFiles.durations.empty() ? 0 : sortedFiles.durations[0];
+    if (chosenCapacity > 0 && chosenCapacity < longest)
+    {
+        cerr << "Error: --capacity is below the longest file (" << durationToTime(longest) << ")" << endl;
+        return false;
+    }
+    auto packable = lower_bound(capacities.begin(), capacities.end(), longest); // capacities are sorted
+    if (packable == capacities.end())
+    {
+        cerr << "Error: every --sweep capacity is below the longest file (" << durationToTime(longest) << ")" << endl;
+        return false;
+    }
+    if (packable != capacities.begin())
+    {
+        cout << "\n" << packable - capacities.begin() << " capacities below the longest file (" << durationToTime(longest)
+            << ") cannot be packed, they are left out" << endl;
+        capacities.erase(capacities.begin(), packable);
+    }
+    cout << "\nCatalog: " << catalog.size() << " files, sorted once in " << sortMilliseconds << " ms, "
+        << capacities.size() << " capacities from " << durationToTime(capacities.front()) << " to " << durationToTime(capacities.back()) << endl;
+
+    vector<vector<SweepCell>> cells(engines.size(), vector<SweepCell>(capacities.size()));
+    vector<AlgorithmReport> reports;
+    if (chosenCapacity > 0) ioPipeline.start(options.ioWorkers, options.ioQueue);
+    for (size_t e = 0; e < engines.size(); e++)
+    {
+        const ShardableEngine& engine = engines[e];
+        const FileList& engineFiles = engine.decreasing ? sortedFiles : files;
+        MetricsScope scope(metricsRegistry.add(engine.id));
+        metrics().scope = engine.folderName;
+        IOBatch batch;
+        for (size_t c = 0; c < capacities.size(); c++)
+        {
+            if (engine.id == "4.1" && durationScale != 1) continue; // duration classes work per second
+
+            resultArena.release(); // the folders of the last capacity are gone
+            FolderTable folders(&resultArena);
+            PhaseTimer packTimer(Phase::Pack);
+            engine.pack(capacities[c], engineFiles.durations, folders);
+            cells[e][c] = { (int)folders.size(), packTimer.stop() / 1e6 };
+
+            if (capacities[c] == chosenCapacity)
+            {
+                fs::create_directories("../Sample Tests/Sample " + testNo + "/OUTPUT/" + engine.folderName);
+                for (size_t f = 0; f < folders.size(); f++)
+                {
+                    processFiles(engineFiles, f + 1, folders[f], engine.folderName, testNo, batch);
+                }
+                ioPipeline.finishBatch(batch);
+                planWriter.finish(engine.folderName);
+                reports.push_back({ engine.folderName, (int)folders.size(), cells[e][c].packMilliseconds, batch.milliseconds });
+            }
+        }
+    }
+    resultArena.release();
+    if (chosenCapacity > 0)
+    {
+        ioPipeline.stop();
+        planWriter.close();
+        removeOtherOutput(testNo, reports);
+    }
+
+    cout << "\nFolder counts:\n";
+    cout << setw(14) << "Capacity" << setw(10) << "Bound";
+    for (const ShardableEngine& engine : engines) cout << setw(10) << engine.id;
+    cout << "\n";
+    for (size_t c = 0; c < capacities.size(); c++)
+    {
+        cout << setw(14) << durationToTime(capacities[c]) << setw(10) << soundpacking::lowerBounds(sortedFiles.durations, capacities[c]).best(); //O(n + d log n)
+        for (size_t e = 0; e < engines.size(); e++)
+        {
+            cout << setw(10) << (cells[e][c].folderCount < 0 ? "-" : to_string(cells[e][c].folderCount));
+        }
+        cout << (capacities[c] == chosenCapacity ? "  written" : "") << "\n";
+    }
+    cout << fixed << setprecision(2) << setw(24) << "Pack ms";
+    for (size_t e = 0; e < engines.size(); e++)
+    {
+        double milliseconds = 0;
+        for (const SweepCell& cell : cells[e]) milliseconds += cell.packMilliseconds;
+        cout << setw(10) << milliseconds;
+    }
+    cout << endl;
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+    return true;
+}
+
+
+
+//########################### PACKING SERVER ###################################
+
+// a catalog the server keeps loaded, read and sorted once
+struct ServedCatalog {
+    int durationScale = 1;
+    FileList files, sortedFiles;
+};
+
+// a "pack" line of a client, answered with the rest of its batch
+struct PackRequest {
+    long long connection = 0;                   // id of the client's connection
+    string catalogId, capacityText, algorithm;
+    chrono::steady_clock::time_point received;
+};
+
+// a client of the server. its socket is non-blocking: a reply is written as far as the socket takes it
+// and the rest waits in output for POLLOUT, so a client that does not read only delays itself
+struct ServerConnection {
+    int socket = -1;
+    string input;               // a line not finished yet
+    string output;              // replies not written yet
+    int pendingRequests = 0;    // pack requests waiting for the next batch
+    bool readClosed = false;    // end of file or read error, no more lines come
+    bool broken = false;        // a write failed, the client is gone and its replies are dropped
+
+    // closed as soon as nothing is left to read, to answer or to write
+    bool done() const { return readClosed && pendingRequests == 0 && (output.empty() || broken); }
+};
+
+#if defined(__unix__) || defined(__APPLE__)
+volatile sig_atomic_t serverInterrupted = 0;
+
+// writes what the socket takes of the pending output
+void flushReplies(ServerConnection& connection)
+{
+    while (!connection.output.empty() && !connection.broken)
+    {
+        ssize_t bytes = write(connection.socket, connection.output.data(), connection.output.size());
+        if (bytes > 0)
+            connection.output.erase(0, bytes);
+        else if (bytes < 0 && errno == EINTR)
+            continue;
+        else if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return;
+        else
+            connection.broken = true;
+    }
+    if (connection.broken) connection.output.clear();
+}
+
+// queues a reply behind the earlier ones of the connection and writes what the socket takes now
+void sendReply(ServerConnection& connection, const string& reply)
+{
+    if (connection.broken) return;
+    connection.output += reply;
+    flushReplies(connection);
+}
+
+// a packing the server would need more memory than this for is refused, the server keeps running for the others
+const long long servedPackingBytes = 1LL << 31;
+
+// rough peak bytes of what an engine allocates besides the folders, for n files and capacity C:
+// the DP table (or its bitset rows, or the sparse states), the duration class rows or the capacity buckets
+//TIME COMPLEXITY: O(1)
+long long packingBytes(const string& engineId, long long files, long long capacity)
+{
+    if (engineId == "4")
+    {
+        if (options.dpEngine == DPEngine::Table) return (files + 1) * (capacity + 1) * (long long)sizeof(int);
+        if (options.dpEngine == DPEngine::Bitset) return (2 * (long long)sqrt((double)files) + 3) * (capacity / 64 + 1) * (long long)sizeof(uint64_t);
+        return (long long)options.dpStates * 3 * (long long)sizeof(int);
+    }
+    if (engineId == "4.1") return min(files, capacity) * (capacity + 1) * (long long)sizeof(int);
+    if (engineId == "3" || engineId == "3.1") return files * (long long)sizeof(long long);
+    return (capacity + 1) * (long long)sizeof(vector<size_t>); // a bucket per capacity value
+}
+
+//answers the requests of one batch: the catalogs are loaded (and sorted) on first use, then the requests of
+//every catalog are grouped by algorithm and capacity so each distinct packing runs once.
+//the reply is the compact plan, "ok <folders>" then one line of catalog file indexes per folder
+//TIME COMPLEXITY: the distinct packings of the batch + O(n log n) for a catalog not loaded yet
+int serveBatch(vector<PackRequest>& batch, unordered_map<long long, ServerConnection>& connections,
+    unordered_map<string, ServedCatalog>& catalogs, LatencyHistogram& latency)
+{
+    PhaseTimer packTimer(Phase::Pack);
+    vector<ShardableEngine> engines = shardableEngines();
+    sort(batch.begin(), batch.end(), [](const PackRequest& a, const PackRequest& b) {
+        return tie(a.catalogId, a.algorithm, a.capacityText) < tie(b.catalogId, b.algorithm, b.capacityText);
+    });
+    auto answer = [&](const PackRequest& request, const string& reply) {
+        ServerConnection& connection = connections.at(request.connection);
+        sendReply(connection, reply);
+        connection.pendingRequests--;
+        latency.add(chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - request.received).count());
+    };
+
+    int packings = 0;
+    for (size_t first = 0, last; first < batch.size(); first = last)
+    {
+        for (last = first; last < batch.size() && batch[last].catalogId == batch[first].catalogId; last++);
+
+        // the catalog, read and sorted the first time it is asked for
+        auto served = catalogs.find(batch[first].catalogId);
+        if (served == catalogs.end() && batch[first].catalogId.find_first_not_of("0123456789") == string::npos
+            && loadCatalog(batch[first].catalogId))
+        {
+            ServedCatalog& loaded = catalogs[batch[first].catalogId];
+            loaded.durationScale = durationScale;
+            loaded.files = catalog.files();
+            loaded.sortedFiles = catalog.files(catalog.decreasingOrder()); //O(nlogn)
+            served = catalogs.find(batch[first].catalogId);
+        }
+        if (served == catalogs.end())
+        {
+            for (size_t r = first; r < last; r++) answer(batch[r], "error no catalog " + batch[r].catalogId + "\n");
+            continue;
+        }
+        ServedCatalog& entry = served->second;
+        int longest = entry.sortedFiles.durations.empty() ? 0 : entry.sortedFiles.durations[0];
+        durationScale = entry.durationScale;
+        if (!options.dpEngineChosen) options.dpEngine = durationScale == 1 ? DPEngine::Table : DPEngine::Sparse; // as a normal run
+
+        // capacities in the units of the catalog
+        vector<int> capacities(last - first, 0);
+        for (size_t r = first; r < last; r++)
+        {
+            if (!parseCapacity(batch[r].capacityText, capacities[r - first]) || capacities[r - first] <= 0)
+                capacities[r - first] = 0;
+        }
+
+        string reply;
+        for (size_t r = first; r < last; r++)
+        {
+            const PackRequest& request = batch[r];
+            bool samePacking = r > first && request.algorithm == batch[r - 1].algorithm && capacities[r - first] == capacities[r - first - 1];
+            if (!samePacking)
+            {
+                auto engine = find_if(engines.begin(), engines.end(), [&](const ShardableEngine& e) { return e.id == request.algorithm; });
+                if (engine == engines.end() || (engine->id == "4.1" && durationScale != 1))
+                    reply = "error algorithm " + request.algorithm + " is not one of 1.2, 2.2, 3, 3.1, 4, 4.1 (second precision), 5, 5.1\n";
+                else if (capacities[r - first] == 0)
+                    reply = "error capacity " + request.capacityText + " is not SECONDS[.mmm]\n";
+                else if (capacities[r - first] < longest)
+                    reply = "error capacity " + request.capacityText + " is below the longest file (" + durationToTime(longest) + ")\n";
+                else if (packingBytes(engine->id, entry.files.size(), capacities[r - first]) > servedPackingBytes)
+                    reply = "error capacity " + request.capacityText + " needs more than " + to_string(servedPackingBytes >> 20)
+                        + " MB with algorithm " + request.algorithm + "\n";
+                else
+                {
+                    resultArena.release(); // the folders of the last packing are gone
+                    try
+                    {
+                        FolderTable folders(&resultArena);
+                        const FileList& list = engine->decreasing ? entry.sortedFiles : entry.files;
+                        engine->pack(capacities[r - first], list.durations, folders);
+                        packings++;
+
+                        reply = "ok " + to_string(folders.size()) + "\n";
+                        for (size_t f = 0; f < folders.size(); f++)
+                        {
+                            for (size_t i = 0; i < folders[f].size(); i++)
+                            {
+                                int fileIndex = folders[f][i];
+                                if (i > 0) reply += ' ';
+                                reply += to_string(list.fileIndex(fileIndex));
+                            }
+                            reply += '\n';
+                        }
+                        count(Counter::FilesPlaced, entry.files.size());
+                    }
+                    catch (const exception& error)
+                    {
+                        // a packing that fails (out of memory...) only fails its own requests
+                        reply = "error algorithm " + request.algorithm + " failed: " + error.what() + "\n";
+                    }
+                }
+            }
+            answer(request, reply);
+        }
+    }
+    resultArena.release();
+    return packings;
+}
+
+//server mode: a long-lived process on a Unix domain socket that keeps the catalogs it was asked for in memory.
+//a client sends lines: "pack <test> <capacity> <algorithm>", "stats" (request latency), "shutdown".
+//the pack requests that arrive within batchWindow milliseconds of the first one are answered together
+//(serveBatch). the latency of a request runs from the server reading its line to its reply being queued,
+//lines are not read while a batch is packed. it stops on shutdown, SIGINT or SIGTERM.
+//an existing file at socketPath is only replaced when it is a socket no server answers on
+//TIME COMPLEXITY: serveBatch for every batch, O(1) per line otherwise
+bool runServer(const string& socketPath, int batchWindow)
+{
+    MetricsScope scope(metricsRegistry.add("serve"));
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socketPath.size() >= sizeof(address.sun_path) || listener < 0)
+    {
+        cerr << "Error: cannot open a Unix domain socket at " << socketPath << endl;
+        return false;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+
+    // a socket left by a server that did not stop cleanly is replaced, anything else stays
+    struct stat existing;
+    if (lstat(socketPath.c_str(), &existing) == 0)
+    {
+        bool live = false;
+        if (S_ISSOCK(existing.st_mode))
+        {
+            int probe = socket(AF_UNIX, SOCK_STREAM, 0);
+            live = probe >= 0 && connect(probe, (sockaddr*)&address, sizeof(address)) == 0;
+            if (probe >= 0) close(probe);
+        }
+        if (!S_ISSOCK(existing.st_mode) || live)
+        {
+            cerr << "Error: " << socketPath << (live ? " is the socket of a running server" : " exists and is not a socket") << endl;
+            close(listener);
+            return false;
+        }
+        unlink(socketPath.c_str());
+    }
+    struct stat created;
+    if (bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0
+        || lstat(socketPath.c_str(), &created) != 0)
+    {
+        cerr << "Error: cannot listen on " << socketPath << ": " << strerror(errno) << endl;
+        close(listener);
+        return false;
+    }
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK); // every waiting client is accepted at once
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, [](int) { serverInterrupted = 1; });
+    signal(SIGTERM, [](int) { serverInterrupted = 1; });
+    cout << "Serving on " << socketPath << " (batch window " << batchWindow << " ms): "
+        << "\"pack <test> <capacity> <algorithm>\", \"stats\", \"shutdown\"" << endl;
+
+    unordered_map<long long, ServerConnection> connections;    // by id, a socket number is reused once closed
+    long long nextConnection = 0;
+    vector<PackRequest> pending;
+    unordered_map<string, ServedCatalog> catalogs;
+    LatencyHistogram latency;
+    long long requests = 0, batches = 0, packings = 0;
+    bool stopping = false;
+    auto statsLine = [&] {
+        ostringstream line;
+        line << "requests " << requests << " batches " << batches << " packings " << packings << " p50_us "
+            << latency.percentile(0.5) / 1e3 << " p99_us " << latency.percentile(0.99) / 1e3 << " max_us " << latency.maxNanoseconds / 1e3;
+        return line.str();
+    };
+    auto closeDone = [&] {
+        for (auto c = connections.begin(); c != connections.end(); )
+        {
+            if (!c->second.done())
+            {
+                ++c;
+                continue;
+            }
+            close(c->second.socket);
+            c = connections.erase(c);
+        }
+    };
+
+    while (true)
+    {
+        auto now = chrono::steady_clock::now();
+        auto deadline = pending.empty() ? now : pending.front().received + chrono::milliseconds(batchWindow);
+        if (!pending.empty() && (now >= deadline || stopping || serverInterrupted))
+        {
+            auto batchStart = chrono::high_resolution_clock::now();
+            int batchPackings = serveBatch(pending, connections, catalogs, latency);
+            packings += batchPackings;
+            batches++;
+            cout << "Batch " << batches << ": " << pending.size() << " requests, " << batchPackings << " packings, "
+                << millisecondsSince(batchStart) << " ms" << endl;
+            pending.clear();
+            closeDone();
+            continue;
+        }
+        if (stopping || serverInterrupted) break;
+
+        // wait for a line, a client ready to take the rest of its replies, or the end of the batch window
+        vector<pollfd> polled{ { listener, POLLIN, 0 } };
+        vector<long long> polledConnections;
+        for (auto& [id, connection] : connections)
+        {
+            short events = (connection.readClosed ? 0 : POLLIN) | (connection.output.empty() ? 0 : POLLOUT);
+            if (events == 0) continue;
+            polled.push_back({ connection.socket, events, 0 });
+            polledConnections.push_back(id);
+        }
+        int timeout = pending.empty() ? -1 : (int)chrono::ceil<chrono::milliseconds>(deadline - now).count();
+        if (poll(polled.data(), polled.size(), timeout) < 0)
+        {
+            if (errno == EINTR) continue;
+            cerr << "Error: poll failed: " << strerror(errno) << endl;
+            break;
+        }
+        if (polled[0].revents & POLLIN)
+        {
+            for (int client; (client = accept(listener, nullptr, nullptr)) >= 0; )
+            {
+                fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK); // not inherited on Linux
+                connections[nextConnection++].socket = client;
+            }
+        }
+        for (size_t p = 1; p < polled.size(); p++)
+        {
+            if (polled[p].revents == 0) continue;
+            long long id = polledConnections[p - 1];
+            ServerConnection& connection = connections.at(id);
+            if (!connection.output.empty()) flushReplies(connection);
+            if (connection.readClosed || (polled[p].revents & (POLLIN | POLLHUP | POLLERR)) == 0) continue;
+            char buffer[65536];
+            ssize_t bytes = read(connection.socket, buffer, sizeof(buffer));
+            if (bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) continue;
+            if (bytes <= 0)
+            {
+                connection.readClosed = true;
+                continue;
+            }
+            connection.input.append(buffer, bytes);
+            auto received = chrono::steady_clock::now();
+            for (size_t newline; (newline = connection.input.find('\n')) != string::npos; )
+            {
+                istringstream line(connection.input.substr(0, newline));
+                connection.input.erase(0, newline + 1);
+                string command, extra;
+                line >> command;
+                if (command == "pack")
+                {
+                    PackRequest request;
+                    request.connection = id;
+                    line >> request.catalogId >> request.capacityText >> request.algorithm;
+                    request.received = received;
+                    requests++;
+                    if (request.algorithm.empty() || line >> extra)
+                        sendReply(connection, "error usage: pack <test> <capacity> <algorithm>\n");
+                    else
+                    {
+                        pending.push_back(move(request));
+                        connection.pendingRequests++;
+                    }
+                }
+                else if (command == "stats")
+                {
+                    sendReply(connection, "ok " + statsLine() + "\n");
+                }
+                else if (command == "shutdown")
+                {
+                    sendReply(connection, "ok\n");
+                    stopping = true;
+                }
+                else if (!command.empty())
+                {
+                    sendReply(connection, "error unknown command " + command + "\n");
+                }
+            }
+        }
+        closeDone();
+    }
+
+    for (auto& [id, connection] : connections) close(connection.socket);
+    close(listener);
+
+    // only the socket this server bound, a later server may have replaced it
+    struct stat current;
+    if (lstat(socketPath.c_str(), &current) == 0 && current.st_dev == created.st_dev && current.st_ino == created.st_ino)
+        unlink(socketPath.c_str());
+    cout << "Stopped: " << statsLine() << ", " << catalogs.size() << " catalogs loaded" << endl;
+    return true;
+}
+#else
+bool runServer(const string& socketPath, int batchWindow)
+{
+    cerr << "Error: --serve needs Unix domain sockets" << endl;
+    return false;
+}
+#endif
+
+
+
+//########################### PARALLEL RUNNER ###################################
+
+// one algorithm of the run, title is what main prints above its output
+struct AlgorithmTask {
+    string id;
+    string title;
+    function<AlgorithmReport()> run;
+    bool expensive = false;     // DP engine, --stop-at-bound runs it last and skips it once the bound is met
+};
+
+// runs one task, its output goes to the current console and its metrics to a scope of its own
+AlgorithmReport runTask(const AlgorithmTask& task)
+{
+    MetricsScope scope(metricsRegistry.add(task.id));
+    console() << "\n-------------------------------------------------------------------------\n";
+    console() << "\n" << task.id << ": " << task.title << "\n";
+    if (options.stopAtBound && task.expensive && boundStop.met)
+    {
+        console() << "Skipped: another engine met the lower bound of " << boundStop.bound << " folders\n";
+        AlgorithmReport report;
+        report.name = "[" + task.id + "] " + task.title.substr(0, task.title.find_last_not_of(": ") + 1);
+        report.stopped = "skipped";
+        metrics().scope = report.name;
+        return report;
+    }
+    AlgorithmReport report;
+    long long allocationsBefore = threadAllocations;
+    string cachedPlan = planCache.path(task.id);
+    if (cachedPlan.empty() || !fs::exists(cachedPlan) || !replayCachedPlan(cachedPlan, report))
+    {
+        recordingPlanPath = cachedPlan;
+        report = task.run();
+        recordingPlanPath.clear();
+    }
+    resultArena.release(); // the folder tables of the task are gone, the next task starts from an empty arena
+    report.allocations = threadAllocations - allocationsBefore;
+    count(Counter::Allocations, report.allocations);
+    if (report.stopped.empty())
+        planWriter.finish(report.name);
+    else
+        planWriter.discard(report.name);
+    metrics().scope = report.name;
+    if (report.stopped.empty() && report.folderCount <= boundStop.bound)
+        boundStop.met = true;
+    return report;
+}
+
+// runs the tasks on "jobs" threads. they only share the catalog (read only) and the I/O pipeline,
+// so each thread collects the output of its tasks and it is printed in task order once all are done.
+// with 1 job the tasks run on the calling thread and print as they go
+vector<AlgorithmReport> runTasks(const vector<AlgorithmTask>& tasks, int jobs)
+{
+    vector<AlgorithmReport> reports(tasks.size());
+    if (jobs <= 1)
+    {
+        for (size_t i = 0; i < tasks.size(); i++)
+            reports[i] = runTask(tasks[i]);
+        return reports;
+    }
+
+    vector<ostringstream> outputs(tasks.size());
+    vector<exception_ptr> errors(tasks.size());
+    atomic<size_t> nextTask{ 0 };
+    vector<thread> threads;
+    for (int t = 0; t < min<int>(jobs, tasks.size()); t++)
+    {
+        threads.emplace_back([&] {
+            for (size_t i = nextTask++; i < tasks.size(); i = nextTask++)
+            {
+                consoleStream = &outputs[i];
+                try
+                {
+                    reports[i] = runTask(tasks[i]);
+                }
+                catch (...)
+                {
+                    errors[i] = current_exception();
+                }
+            }
+            consoleStream = &cout;
+        });
+    }
+    for (thread& worker : threads) worker.join();
+
+    for (size_t i = 0; i < tasks.size(); i++)
+    {
+        cout << outputs[i].str();
+        if (errors[i]) rethrow_exception(errors[i]);
+    }
+    cout.flush();
+    return reports;
+}
+
+// folder count against the lower bound, packing time and I/O time of every algorithm,
+// wall time is the whole run
+void printSummary(const vector<AlgorithmReport>& reports, const LowerBounds& bounds, int jobs, double wallMilliseconds)
+{
+    cout << "\n-------------------------------------------------------------------------\n";
+    cout << "\nSummary (" << jobs << (jobs == 1 ? " job" : " jobs") << ", "
+        << fixed << setprecision(2) << wallMilliseconds << " ms wall, lower bound " << bounds.best() << " folders):\n";
+    cout << left << setw(48) << "Algorithm" << right << setw(10) << "Folders" << setw(12) << "vs bound"
+        << setw(14) << "Pack ms" << setw(14) << "I/O ms" << setw(14) << "Allocations" << "\n";
+    for (const AlgorithmReport& report : reports)
+    {
+        cout << left << setw(48) << report.name << right;
+        if (!report.stopped.empty())
+        {
+            cout << setw(10) << "-" << setw(12) << report.stopped;
+        }
+        else
+        {
+            long long gap = report.folderCount - bounds.best();
+            cout << setw(10) << report.folderCount << setw(12) << (gap == 0 ? "optimal" : "+" + to_string(gap));
+        }
+        cout << setw(14) << report.packMilliseconds << setw(14) << report.ioMilliseconds << setw(14) << report.allocations << "\n";
+    }
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+}
+
+
+
+//########################### METRICS EXPORT ###################################
+
+// scope names are folder names, quotes and backslashes are the only characters to escape
+string escapeMetricsText(const string& text)
+{
+    string escaped;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\') escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+// one object per scope: time and calls of every phase, and every counter
+void writeMetricsJson(ostream& out, double wallMilliseconds)
+{
+    out << "{\n  \"wall_seconds\": " << wallMilliseconds / 1000 << ",\n  \"scopes\": [\n";
+    for (size_t s = 0; s < metricsRegistry.scopes.size(); s++)
+    {
+        const Metrics& scope = metricsRegistry.scopes[s];
+        out << "    {\"scope\": \"" << escapeMetricsText(scope.scope) << "\", \"phases\": {";
+        for (int p = 0; p < (int)Phase::Count; p++)
+        {
+            out << (p ? ", " : "") << "\"" << phaseNames[p] << "\": {\"seconds\": " << scope.phaseNanoseconds[p] / 1e9
+                << ", \"calls\": " << scope.phaseCalls[p] << "}";
+        }
+        out << "}, \"counters\": {";
+        for (int c = 0; c < (int)Counter::Count; c++)
+        {
+            out << (c ? ", " : "") << "\"" << counterNames[c] << "\": " << scope.counters[c];
+        }
+        out << "}}" << (s + 1 < metricsRegistry.scopes.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// Prometheus text format, every series labelled with its scope (the run or the algorithm)
+void writeMetricsPrometheus(ostream& out, double wallMilliseconds)
+{
+    out << "# HELP sound_packing_wall_seconds Wall time of the algorithms (or of the apply step).\n";
+    out << "# TYPE sound_packing_wall_seconds gauge\n";
+    out << "sound_packing_wall_seconds " << wallMilliseconds / 1000 << "\n";
+
+    out << "# HELP sound_packing_phase_seconds_total Time spent per phase (nested phases are counted in their parent too).\n";
+    out << "# TYPE sound_packing_phase_seconds_total counter\n";
+    for (const Metrics& scope : metricsRegistry.scopes)
+        for (int p = 0; p < (int)Phase::Count; p++)
+            out << "sound_packing_phase_seconds_total{scope=\"" << escapeMetricsText(scope.scope) << "\",phase=\""
+                << phaseNames[p] << "\"} " << scope.phaseNanoseconds[p] / 1e9 << "\n";
+
+    out << "# HELP sound_packing_phase_calls_total Times each phase ran.\n";
+    out << "# TYPE sound_packing_phase_calls_total counter\n";
+    for (const Metrics& scope : metricsRegistry.scopes)
+        for (int p = 0; p < (int)Phase::Count; p++)
+            out << "sound_packing_phase_calls_total{scope=\"" << escapeMetricsText(scope.scope) << "\",phase=\""
+                << phaseNames[p] << "\"} " << scope.phaseCalls[p] << "\n";
+
+    for (int c = 0; c < (int)Counter::Count; c++)
+    {
+        out << "# TYPE sound_packing_" << counterNames[c] << "_total counter\n";
+        for (const Metrics& scope : metricsRegistry.scopes)
+            out << "sound_packing_" << counterNames[c] << "_total{scope=\"" << escapeMetricsText(scope.scope) << "\"} "
+                << scope.counters[c] << "\n";
+    }
+}
+
+// writes the metrics of the run to options.metricsPath, if asked for
+bool writeMetrics(double wallMilliseconds)
+{
+    if (options.metricsPath.empty()) return true;
+    ofstream out(options.metricsPath);
+    if (!out.is_open())
+    {
+        cerr << "Error: Could not write " << options.metricsPath << endl;
+        return false;
+    }
+    if (options.metricsPrometheus)
+        writeMetricsPrometheus(out, wallMilliseconds);
+    else
+        writeMetricsJson(out, wallMilliseconds);
+    return true;
+}
+
+
+
+//########################### MAIN ###################################
+
+const char* materializeModeNames[] = { "copy", "hardlink", "reflink", "copy-range", "symlink", "metadata" };
+
+// reads --name=value options, returns false on anything it does not know
+bool parseOptions(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; i++)
+    {
+        string argument = argv[i];
+        size_t equals = argument.find('=');
+        string name = argument.substr(0, equals);
+        string value = equals == string::npos ? "" : argument.substr(equals + 1);
+        bool valid = false;
+
+        if (name == "--dp")
+        {
+            valid = (value == "table" || value == "bitset" || value == "sparse");
+            options.dpEngine = (value == "bitset") ? DPEngine::Bitset : (value == "sparse") ? DPEngine::Sparse : DPEngine::Table;
+            options.dpEngineChosen = true;
+        }
+        else if (name == "--dp-states")
+        {
+            valid = !value.empty() && value.size() < 12 && value.find_first_not_of("0123456789") == string::npos && stoll(value) > 0;
+            if (valid)
+                options.dpStates = stoll(value);
+        }
+        else if (name == "--epsilon")
+        {
+            char* parsed = nullptr;
+            options.epsilon = value.empty() ? 0 : strtod(value.c_str(), &parsed);
+            valid = !value.empty() && *parsed == 0 && options.epsilon > 0 && options.epsilon <= 1;
+        }
+        else if (name == "--precision")
+        {
+            valid = (value == "auto" || value == "s" || value == "ms");
+            options.precision = (value == "s") ? DurationPrecision::Seconds
+                : (value == "ms") ? DurationPrecision::Milliseconds : DurationPrecision::Auto;
+        }
+        else if (name == "--io-workers" || name == "--io-queue")
+        {
+            valid = !value.empty() && value.find_first_not_of("0123456789") == string::npos;
+            if (valid)
+                (name == "--io-workers" ? options.ioWorkers : options.ioQueue) = stoi(value);
+        }
+        else if (name == "--jobs")
+        {
+            valid = !value.empty() && value.find_first_not_of("0123456789") == string::npos && stoi(value) > 0;
+            if (valid)
+                options.jobs = stoi(value);
+        }
+        else if (name == "--algorithms")
+        {
+            stringstream ids(value);
+            string id;
+            options.algorithms.clear();
+            while (getline(ids, id, ','))
+            {
+                if (!id.empty()) options.algorithms.push_back(id);
+            }
+            valid = !options.algorithms.empty();
+        }
+        else if (name == "--sweep")
+        {
+            stringstream items(value);
+            string item;
+            options.sweep.clear();
+            while (getline(items, item, ','))
+            {
+                if (!item.empty()) options.sweep.push_back(item);
+            }
+            valid = !options.sweep.empty();
+        }
+        else if (name == "--serve")
+        {
+            valid = !value.empty();
+            options.servePath = value;
+        }
+        else if (name == "--batch-window")
+        {
+            valid = !value.empty() && value.size() < 6 && value.find_first_not_of("0123456789") == string::npos;
+            if (valid) options.batchWindow = stoi(value);
+        }
+        else if (name == "--metrics")
+        {
+            valid = !value.empty();
+            options.metricsPath = value;
+        }
+        else if (name == "--metrics-format")
+        {
+            valid = (value == "json" || value == "prometheus");
+            options.metricsPrometheus = (value == "prometheus");
+        }
+        else if (name == "--stream")
+        {
+            valid = !value.empty();
+            options.streamPath = value;
+        }
+        else if (name == "--stream-fit")
+        {
+            valid = (value == "worst" || value == "best");
+            options.streamBestFit = (value == "best");
+        }
+        else if (name == "--close-at" || name == "--max-age" || name == "--max-open" || name == "--follow" || name == "--capacity")
+        {
+            valid = !value.empty() && value.size() < 10 && value.find_first_not_of("0123456789") == string::npos;
+            if (valid)
+            {
+                int number = stoi(value);
+                if (name == "--close-at") options.streamCloseAt = number;
+                if (name == "--max-age") options.streamMaxAge = number;
+                if (name == "--max-open") options.streamMaxOpen = number;
+                if (name == "--follow") options.streamFollow = number;
+                if (name == "--capacity") options.capacity = number;
+                valid = (name == "--close-at") ? number >= 1 && number <= 100 : (name == "--max-open" || name == "--capacity") ? number > 0 : true;
+            }
+        }
+        else if (name == "--shards" || name == "--repair-below")
+        {
+            valid = !value.empty() && value.size() < 10 && value.find_first_not_of("0123456789") == string::npos;
+            if (valid)
+            {
+                (name == "--shards" ? options.shards : options.repairBelow) = stoi(value);
+                valid = (name == "--shards") ? options.shards > 0 : options.repairBelow <= 100;
+            }
+        }
+        else if (name == "--skip-unsharded")
+        {
+            valid = value.empty();
+            options.skipUnsharded = true;
+        }
+        else if (name == "--no-cache")
+        {
+            valid = value.empty();
+            options.planCache = false;
+        }
+        else if (name == "--scan")
+        {
+            valid = value.empty();
+            options.scan = true;
+        }
+        else if (name == "--scan-threads")
+        {
+            valid = !value.empty() && value.find_first_not_of("0123456789") == string::npos && value.size() < 6;
+            if (valid) options.scanThreads = stoi(value);
+        }
+        else if (name == "--test")
+        {
+            valid = !value.empty() && value.find_first_not_of("0123456789") == string::npos;
+            options.testNo = value;
+        }
+        else if (name == "--stop-at-bound")
+        {
+            valid = value.empty();
+            options.stopAtBound = true;
+        }
+        else if (name == "--plan-only")
+        {
+            valid = value.empty();
+            options.planOnly = true;
+        }
+        else if (name == "--apply")
+        {
+            valid = !value.empty();
+            options.applyPlan = value;
+        }
+        else if (name == "--materialize")
+        {
+            for (int mode = 0; mode < 6; mode++)
+            {
+                if (value == materializeModeNames[mode])
+                {
+                    options.materialize = (MaterializeMode)mode;
+                    valid = true;
+                }
+            }
+        }
+
+        if (!valid)
+        {
+            cerr << "Unknown option: " << argument << endl;
+            cerr << "Options: --dp=table|bitset|sparse, --dp-states=N, --epsilon=E (sparse engine fallback)" << endl;
+            cerr << "         --precision=auto|s|ms (durations HH:MM:SS or HH:MM:SS.mmm)" << endl;
+            cerr << "         --materialize=copy|hardlink|reflink|copy-range|symlink|metadata" << endl;
+            cerr << "         --io-workers=N (0 = main thread), --io-queue=N" << endl;
+            cerr << "         --plan-only, --apply=<plan file>" << endl;
+            cerr << "         --jobs=N (algorithms packed in parallel), --algorithms=1,1.1,1.2,2,2.1,2.2,3,3.1,4,4.1,5,5.1" << endl;
+            cerr << "         --metrics=<file> (phase times and counters), --metrics-format=json|prometheus" << endl;
+            cerr << "         --stop-at-bound (skip the DP engines once a faster one meets the lower bound)" << endl;
+            cerr << "         --stream=<file>|- --test=N --capacity=SECONDS (pack entries as they arrive)" << endl;
+            cerr << "           --stream-fit=worst|best, --close-at=PERCENT, --max-age=SECONDS, --max-open=N, --follow=SECONDS" << endl;
+            cerr << "         --shards=N (--algorithms=1.2,2.2,3,3.1,4,4.1,5,5.1 packed as N shards in parallel)" << endl;
+            cerr << "           --repair-below=PERCENT, --skip-unsharded" << endl;
+            cerr << "         --no-cache (pack even when the plan cache has the algorithm for this catalog and capacity)" << endl;
+            cerr << "         --sweep=SECONDS,FROM-TO:STEP,... [--test=N] [--capacity=SECONDS] (folder counts for every capacity," << endl;
+            cerr << "           the folders of --capacity are written)" << endl;
+            cerr << "         --serve=<socket> [--batch-window=MS] (packing server: \"pack <test> <capacity> <algorithm>\", \"stats\", \"shutdown\")" << endl;
+            cerr << "         --scan, --scan-threads=N (durations from the MP3 headers of INPUT/Audios, 0 = one thread per core)" << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifndef SOUND_PACKING_NO_MAIN // the benchmark includes this file for the engines and brings its own main
+int main(int argc, char* argv[])
+{
+    if (!parseOptions(argc, argv))
+    {
+        return 1;
+    }
+
+    //apply step: build the folders of an existing plan, no packing and no questions
+    if (!options.applyPlan.empty())
+    {
+        auto applyStart = chrono::high_resolution_clock::now();
+        ioPipeline.start(options.ioWorkers, options.ioQueue);
+        bool applied = applyPlan(options.applyPlan);
+        ioPipeline.stop();
+        bool metricsWritten = writeMetrics(millisecondsSince(applyStart));
+        return applied && metricsWritten ? 0 : 1;
+    }
+
+    //streaming step: entries are packed as they arrive, no catalog and no questions
+    if (!options.streamPath.empty())
+    {
+        if (options.testNo.empty() || options.capacity == 0 || options.planOnly)
+        {
+            cerr << "Error: --stream needs --test=N and --capacity=SECONDS, and writes folders (no --plan-only)" << endl;
+            return 1;
+        }
+        durationScale = (options.precision == DurationPrecision::Milliseconds) ? 1000 : 1;
+        if ((long long)options.capacity * durationScale >= INT32_MAX)
+        {
+            cerr << "Error: --capacity is too large" << endl;
+            return 1;
+        }
+        auto streamStart = chrono::high_resolution_clock::now();
+        ioPipeline.start(options.ioWorkers, options.ioQueue);
+        bool streamed = runStream(options.streamPath, options.testNo, options.capacity * durationScale);
+        ioPipeline.stop();
+        bool metricsWritten = writeMetrics(millisecondsSince(streamStart));
+        return streamed && metricsWritten ? 0 : 1;
+    }
+
+    //server step: requests come from a socket, no questions
+    if (!options.servePath.empty())
+    {
+        auto serveStart = chrono::high_resolution_clock::now();
+        bool served = runServer(options.servePath, options.batchWindow);
+        return served && writeMetrics(millisecondsSince(serveStart)) ? 0 : 1;
+    }
+
+    int x = options.testNo.empty() ? 0 : stoi(options.testNo);
+    while (x < 1 || x > 6 || (x == 0))
+    {
+        cout << "NOTE: Tests(1,2,3) are for small inputs, Tests(4,5,6) are for large inputs\n";
+        cout << "Enter test number (1,2,3,4,5,6): ";
+        cin >> x;
+    }
+
+    string testNo = to_string(x);
+    
+    if (!loadCatalog(testNo))
+    {
+        return 1;
+    }
+    double readMilliseconds = runMetrics.phaseNanoseconds[(int)Phase::Parse] / 1e6;
+
+    //sweep step: folder counts for every capacity of --sweep, no question about the capacity
+    if (!options.sweep.empty())
+    {
+        vector<int> capacities;
+        if (options.shards > 0 || !parseSweep(options.sweep, capacities))
+        {
+            cerr << "Error: --sweep takes SECONDS[.mmm] and FROM-TO:STEP capacities (up to 10000 per range), without --shards" << endl;
+            return 1;
+        }
+        int chosenCapacity = 0;
+        if (options.capacity > 0)
+        {
+            if ((long long)options.capacity * durationScale >= INT32_MAX)
+            {
+                cerr << "Error: --capacity is too large" << endl;
+                return 1;
+            }
+            chosenCapacity = options.capacity * durationScale;
+            capacities.insert(lower_bound(capacities.begin(), capacities.end(), chosenCapacity), chosenCapacity);
+            capacities.erase(unique(capacities.begin(), capacities.end()), capacities.end());
+            filesystem::create_directories("../Sample Tests/Sample " + testNo + "/OUTPUT");
+        }
+        auto sweepStart = chrono::high_resolution_clock::now();
+        bool swept = runSweep(testNo, capacities, chosenCapacity);
+        return swept && writeMetrics(millisecondsSince(sweepStart)) ? 0 : 1;
+    }
+
+    cout << "FOLDER CAPACITY CANT BE LESS THAN THE MAXIMUM AUDIO CAPACITY TO AVOID INFINITE LOOP\n";
+    cout << "Input folder capacity in seconds according to the sample test readme.txt: ";
+    string capacityText;
+    cin >> capacityText;
+    int folderCapacity;
+    if (!parseCapacity(capacityText, folderCapacity))
+    {
+        cerr << "Error: the folder capacity is SECONDS or SECONDS.mmm" << endl;
+        return 1;
+    }
+    if (durationScale != 1 && !options.dpEngineChosen)
+    {
+        options.dpEngine = DPEngine::Sparse; // a table column per millisecond would not fit in memory
+    }
+
+    //an existing OUTPUT is kept: every algorithm syncs its folders with what is already there
+    //and whatever this run does not write is removed at the end
+    filesystem::create_directories("../Sample Tests/Sample " + testNo + "/OUTPUT");
+    planCache.open(testNo, folderCapacity);
+
+    //the catalog is read only from here on, the decreasing variants share one sorted copy
+    //(sorted as a permutation of the catalog, the lists only hold durations and that permutation)
+    PhaseTimer sortTimer(Phase::Sort);
+    vector<int> decreasingOrder = catalog.decreasingOrder(); //O(nlogn)
+    double sortMilliseconds = sortTimer.stop() / 1e6;
+    FileList files = catalog.files();
+    FileList sortedFiles = catalog.files(move(decreasingOrder));
+
+    cout << "\nCatalog: " << catalog.size() << " files, " << catalog.names.size() / 1024.0 << " KB of names, read in "
+        << readMilliseconds << " ms, sorted in " << sortMilliseconds << " ms"
+        << (durationScale == 1000 ? ", millisecond precision" : "") << endl;
+
+    LowerBounds bounds = soundpacking::lowerBounds(sortedFiles.durations, folderCapacity); //O(n + d log n)
+    boundStop.bound = bounds.best();
+    cout << "Lower bounds: ceil(sum/C) = " << bounds.l1 << " folders, Martello-Toth L2 = " << bounds.l2 << " folders" << endl;
+
+    vector<AlgorithmTask> tasks = {
+        { "1", "Worst-Fit using Priority Queue:", [&] { return worstFitPQCaller(folderCapacity, files, testNo); } },
+        { "1.1", "Worst-Fit using Linear Search:", [&] { return worstFitLinearCaller(folderCapacity, files, testNo); } },
+        { "1.2", "Worst-Fit using a Bucket Queue:", [&] { return worstFitBucketsCaller(folderCapacity, files, testNo, false); } },
+        { "2", "Worst-Fit Decreasing using Priority Queue:", [&] { return worstFitDecreasingPQCaller(folderCapacity, sortedFiles, testNo); } },
+        { "2.1", "Worst-Fit Decreasing using Linear Search:", [&] { return WFDLinearCaller(folderCapacity, sortedFiles, testNo); } },
+        { "2.2", "Worst-Fit Decreasing using a Bucket Queue:", [&] { return worstFitBucketsCaller(folderCapacity, sortedFiles, testNo, true); } },
+        { "3", "First-Fit Decreasing: ", [&] { return FirstFitDecreasing(folderCapacity, sortedFiles, testNo); } },
+        { "3.1", "First-Fit Decreasing using Tournament Tree: ", [&] { return FirstFitDecreasing(folderCapacity, sortedFiles, testNo, true); } },
+        { "4", "Folder Filling Algorithm:", [&] { return folderFilling(folderCapacity, files, testNo); }, true },
+        { "4.1", "Folder Filling using Duration Classes:", [&] { return folderFillingClasses(folderCapacity, files, testNo); }, true },
+        { "5", "Best-Fit using Capacity Buckets:", [&] { return BestFitCaller(folderCapacity, files, testNo, false); } },
+        { "5.1", "Best-Fit Decreasing using Capacity Buckets:", [&] { return BestFitCaller(folderCapacity, sortedFiles, testNo, true); } },
+    };
+    //rest of algorithms should be added here
+
+    if (options.shards > 0)
+    {
+        // sharded mode runs the engines that place files by index instead
+        tasks.clear();
+        for (const ShardableEngine& engine : shardableEngines())
+        {
+            tasks.push_back({ engine.id, engine.folderName.substr(engine.folderName.find(' ') + 1) + " in " + to_string(options.shards) + " shards:",
+                [&, engine] { return shardedCaller(engine, folderCapacity, engine.decreasing ? sortedFiles : files, bounds, testNo); },
+                engine.id == "4" || engine.id == "4.1" });
+        }
+    }
+
+    if (!options.algorithms.empty())
+    {
+        vector<AlgorithmTask> selected;
+        for (const string& id : options.algorithms)
+        {
+            auto task = find_if(tasks.begin(), tasks.end(), [&](const AlgorithmTask& t) { return t.id == id; });
+            if (task == tasks.end())
+            {
+                cerr << "Unknown algorithm: " << id << endl;
+                return 1;
+            }
+            selected.push_back(*task);
+        }
+        tasks = selected;
+    }
+    if (options.stopAtBound)
+    {
+        // the fast engines first, so the DP engines can be skipped when one of them is optimal
+        stable_partition(tasks.begin(), tasks.end(), [](const AlgorithmTask& task) { return !task.expensive; });
+    }
+
+    ioPipeline.start(options.ioWorkers, options.ioQueue);
+    auto runStart = chrono::high_resolution_clock::now();
+    vector<AlgorithmReport> reports = runTasks(tasks, options.jobs);
+    double wallMilliseconds = millisecondsSince(runStart);
+
+    ioPipeline.stop();
+    planWriter.close();
+    removeOtherOutput(testNo, reports);
+    planCache.prune(64);
+    if (options.planOnly)
+    {
+        cout << "\nPlan only: manifests written to ../Sample Tests/Sample " << testNo << "/OUTPUT/*.plan" << endl;
+    }
+
+    printSummary(reports, bounds, options.jobs, wallMilliseconds);
+
+    cout << "\n-------------------------------------------------------------------------\n";
+    cout << "\nMaterialization (" << materializeModeNames[(int)options.materialize] << "): "
+        << materializeStats.bytesWritten / 1048576.0 << " MB written, "
+        << materializeStats.bytesReferenced / 1048576.0 << " MB referenced, "
+        << materializeStats.fallbacks << " files fell back to a copy" << endl;
+    return writeMetrics(wallMilliseconds) ? 0 : 1;
+}
+#endif